@@ -71,6 +71,77 @@ gchar *decode_from_octal_str(const char *name)
 	return g_strdup(buff);
 }
 
+/*
+ * Decoded names for display, owned by the caches below; callers copy them if
+ * they keep them. A name without '\\' is returned as is.
+ *
+ * get_display_name() is for names from ccs_savename() (or a pointer into
+ * one) and looks them up by address. Such pointers stay valid until
+ * ccs_savename_reclaim() frees something, which is seen as a change of the
+ * reclaimed bytes of get_name_usage(), so the cache is emptied then.
+ *
+ * get_display_text() is for other strings (operands, process domains) and
+ * looks them up by contents.
+ */
+#define DISPLAY_TEXT_CACHE_MAX	65536
+
+static GHashTable	*display_name_cache = NULL;
+static unsigned long	display_name_epoch = 0;
+static GHashTable	*display_text_cache = NULL;
+
+const gchar *get_display_name(const char *name)
+{
+	unsigned long	live, reclaimed;
+	gchar		*decoded;
+
+	if (!strchr(name, '\\'))
+		return name;
+
+	get_name_usage(&live, &reclaimed);
+	if (display_name_cache && reclaimed != display_name_epoch) {
+		g_hash_table_destroy(display_name_cache);
+		display_name_cache = NULL;
+	}
+	if (!display_name_cache) {
+		display_name_cache = g_hash_table_new_full(
+				g_direct_hash, g_direct_equal, NULL, g_free);
+		display_name_epoch = reclaimed;
+	}
+
+	decoded = g_hash_table_lookup(display_name_cache, name);
+	if (!decoded) {
+		decoded = decode_from_octal_str(name);
+		g_hash_table_insert(display_name_cache,
+					(gpointer)name, decoded);
+	}
+	return decoded;
+}
+
+const gchar *get_display_text(const char *text)
+{
+	gchar		*decoded;
+
+	if (!strchr(text, '\\'))
+		return text;
+
+	if (display_text_cache &&
+	    g_hash_table_size(display_text_cache) >= DISPLAY_TEXT_CACHE_MAX) {
+		g_hash_table_destroy(display_text_cache);
+		display_text_cache = NULL;
+	}
+	if (!display_text_cache)
+		display_text_cache = g_hash_table_new_full(
+				g_str_hash, g_str_equal, g_free, g_free);
+
+	decoded = g_hash_table_lookup(display_text_cache, text);
+	if (!decoded) {
+		decoded = decode_from_octal_str(text);
+		g_hash_table_insert(display_text_cache,
+					g_strdup(text), decoded);
+	}
+	return decoded;
+}
+
 /*---------------------------------------------------------------------------*/
 static gboolean is_jump_source(
 			struct ccs_domain_policy3 *dp, const int index)
@@ -92,122 +163,589 @@ enum tree_column_pos {
 	N_COLUMNS_TREE
 };
 /*---------------------------------------------------------------------------*/
-static int add_tree_store(GtkTreeStore *store, GtkTreeIter *parent_iter,
-			struct ccs_domain_policy3 *dp, int *index, int nest)
+/*
+ * DomainModel is a GtkTreeModel which reads rows directly from
+ * "struct ccs_domain_policy3". Only the shape of the tree is built in advance;
+ * strings of a row are made when the view asks for them, so that the cost of
+ * a refresh does not depend on the number of columns nor on rows not shown.
+ *
+ * A GtkTreeIter holds the index in dp->list in user_data.
+ *
+ * While the domain policy is read into an empty view, domainnames are added
+ * as flat rows after the domains (see add_preview_row()) until the model is
+ * replaced by one for the policy read.
+ */
+typedef struct _DomainModel {
+	GObject		parent;
+	gint		stamp;
+	struct ccs_domain_policy3	*dp;
+	gint		count;		// number of rows (dp->list_len)
+	gint		*parent_row;	// index of parent row, -1 if root
+	gint		*nth;		// position among siblings
+	gint		*n_children;	// number of children
+	gint		*child_start;	// offset of children in "children"
+	gint		*children;	// rows ordered by parent, roots first
+	gint		n_roots;
+	GPtrArray	*preview;	// domainnames of preview rows
+	gint		preview_len;	// length of the longest of them
+} DomainModel;
+
+typedef struct _DomainModelClass {
+	GObjectClass	parent_class;
+} DomainModelClass;
+
+static void domain_model_tree_model_init(GtkTreeModelIface *iface);
+
+G_DEFINE_TYPE_WITH_CODE(DomainModel, domain_model, G_TYPE_OBJECT,
+	G_IMPLEMENT_INTERFACE(GTK_TYPE_TREE_MODEL,
+				domain_model_tree_model_init))
+
+#define DOMAIN_MODEL(obj) \
+	(G_TYPE_CHECK_INSTANCE_CAST((obj), domain_model_get_type(), \
+							DomainModel))
+#define IS_DOMAIN_MODEL(obj) \
+	(G_TYPE_CHECK_INSTANCE_TYPE((obj), domain_model_get_type()))
+#define ITER_INDEX(iter)	GPOINTER_TO_INT((iter)->user_data)
+
+static void domain_model_init(DomainModel *model)
 {
-	GtkTreeIter	iter;
-	gchar		*color = "black";
-	gchar		*str_num, *str_prof, *name;
-	gchar		*line = NULL, *is_dis = NULL, *domain;
-	const char	*sp;
-	const struct ccs_transition_control_entry *transition_control;
-	int		n, number, redirect_index = -1;
+	model->stamp = g_random_int();
+}
 
-//g_print("add_tree_store index[%3d] nest[%2d]\n", *index, nest);
+static void domain_model_finalize(GObject *object)
+{
+	DomainModel	*model = DOMAIN_MODEL(object);
+
+	g_free(model->parent_row);
+	g_free(model->nth);
+	g_free(model->n_children);
+	g_free(model->child_start);
+	g_free(model->children);
+	if (model->preview) {
+		g_ptr_array_foreach(model->preview, (GFunc)g_free, NULL);
+		g_ptr_array_free(model->preview, TRUE);
+	}
+	G_OBJECT_CLASS(domain_model_parent_class)->finalize(object);
+}
+
+static void domain_model_class_init(DomainModelClass *klass)
+{
+	G_OBJECT_CLASS(klass)->finalize = domain_model_finalize;
+}
 
-	sp = get_domain_name(dp, *index);
-	for (n = 0; ; n++) {
-		const char *cp = strchr(sp, ' ');
-		if (!cp)
+/*
+ * Same shape as the former GtkTreeStore: the first row is the only root and
+ * every following row is a child of the nearest preceding row with a smaller
+ * depth.
+ */
+static void domain_model_build(DomainModel *model)
+{
+	struct ccs_domain_policy3	*dp = model->dp;
+	gint		*stack, *fill;
+	gint		sp = 0, i, pos;
+
+	model->count = dp ? dp->list_len : 0;
+	model->parent_row = g_new(gint, model->count);
+	model->nth = g_new(gint, model->count);
+	model->n_children = g_new0(gint, model->count);
+	model->child_start = g_new(gint, model->count);
+	model->children = g_new(gint, model->count);
+	model->n_roots = 0;
+	if (!model->count)
+		return;
+
+	stack = g_new(gint, model->count);
+	for (i = 0; i < model->count; i++) {
+		gint	depth = get_domain_depth(dp, i);
+		gint	parent;
+
+		/* The first row takes all rows as descendants. */
+		while (sp > 1 && get_domain_depth(dp, stack[sp - 1]) >= depth)
+			sp--;
+		parent = sp ? stack[sp - 1] : -1;
+		model->parent_row[i] = parent;
+		if (parent < 0)
+			model->nth[i] = model->n_roots++;
+		else
+			model->nth[i] = model->n_children[parent]++;
+		stack[sp++] = i;
+	}
+	g_free(stack);
+
+	pos = model->n_roots;
+	for (i = 0; i < model->count; i++) {
+		model->child_start[i] = pos;
+		pos += model->n_children[i];
+	}
+	fill = model->children;
+	for (i = 0; i < model->count; i++) {
+		gint	parent = model->parent_row[i];
+
+		fill[(parent < 0 ? 0 : model->child_start[parent]) +
+						model->nth[i]] = i;
+	}
+}
+
+static GtkTreeModel *domain_model_new(struct ccs_domain_policy3 *dp)
+{
+	DomainModel	*model = g_object_new(domain_model_get_type(), NULL);
+
+	model->dp = dp;
+	domain_model_build(model);
+	return GTK_TREE_MODEL(model);
+}
+
+/* Preview rows have indexes from model->count. */
+static gint domain_model_n_preview(DomainModel *model)
+{
+	return model->preview ? model->preview->len : 0;
+}
+
+static gboolean domain_model_set_iter(DomainModel *model,
+					GtkTreeIter *iter, gint index)
+{
+	if (index < 0 || index >= model->count + domain_model_n_preview(model)) {
+		iter->stamp = 0;
+		return FALSE;
+	}
+	iter->stamp = model->stamp;
+	iter->user_data = GINT_TO_POINTER(index);
+	return TRUE;
+}
+
+/* Returns the index of the n-th child of @parent (-1 for roots). */
+static gint domain_model_nth_child(DomainModel *model, gint parent, gint n)
+{
+	if (parent < 0) {
+		if (n < model->n_roots)
+			return model->children[n];
+		n -= model->n_roots;
+		return n < domain_model_n_preview(model) ?
+					model->count + n : -1;
+	}
+	if (parent >= model->count || n >= model->n_children[parent])
+		return -1;
+	return model->children[model->child_start[parent] + n];
+}
+
+static GtkTreeModelFlags domain_model_get_flags(GtkTreeModel *tree_model)
+{
+	return GTK_TREE_MODEL_ITERS_PERSIST;
+}
+
+static gint domain_model_get_n_columns(GtkTreeModel *tree_model)
+{
+	return N_COLUMNS_TREE;
+}
+
+static GType domain_model_get_column_type(GtkTreeModel *tree_model,
+							gint column)
+{
+	return column == COLUMN_INDEX || column == COLUMN_REDIRECT ?
+						G_TYPE_INT : G_TYPE_STRING;
+}
+
+static gboolean domain_model_get_iter(GtkTreeModel *tree_model,
+				GtkTreeIter *iter, GtkTreePath *path)
+{
+	DomainModel	*model = DOMAIN_MODEL(tree_model);
+	gint		*indices = gtk_tree_path_get_indices(path);
+	gint		depth = gtk_tree_path_get_depth(path);
+	gint		i, index = -1;
+
+	for (i = 0; i < depth; i++) {
+		index = domain_model_nth_child(model, index, indices[i]);
+		if (index < 0)
 			break;
-		sp = cp + 1;
 	}
-	name = decode_from_octal_str(sp);
+	return domain_model_set_iter(model, iter, index);
+}
 
-	gtk_tree_store_append(store, &iter, parent_iter);
-	number = dp->list[*index].number;
-	if (number >= 0) {
-		str_num = g_strdup_printf("%4d", number);
-		str_prof = g_strdup_printf("%3u", dp->list[*index].profile);
-	} else {
-		str_num = g_strdup("");
-		str_prof = g_strdup("");
+static GtkTreePath *domain_model_get_path(GtkTreeModel *tree_model,
+						GtkTreeIter *iter)
+{
+	DomainModel	*model = DOMAIN_MODEL(tree_model);
+	GtkTreePath	*path = gtk_tree_path_new();
+	gint		index;
+
+	g_return_val_if_fail(iter->stamp == model->stamp, path);
+	index = ITER_INDEX(iter);
+	if (index >= model->count) {
+		gtk_tree_path_append_index(path,
+				model->n_roots + index - model->count);
+		return path;
 	}
+	for (; index >= 0; index = model->parent_row[index])
+		gtk_tree_path_prepend_index(path, model->nth[index]);
+	return path;
+}
 
-	gtk_tree_store_set(store, &iter,
-		COLUMN_INDEX,		*index,
-		COLUMN_NUMBER,  	str_num,
-		COLUMN_COLON,		number >= 0 ? ":" : "",
-		COLUMN_PROFILE,		str_prof,
-		COLUMN_KEEPER_DOMAIN,	dp->list[*index].is_dk ? "#" : " ",
-		COLUMN_INITIALIZER_TARGET, dp->list[*index].is_djt ? "*" : " ",
-		COLUMN_DOMAIN_UNREACHABLE, dp->list[*index].is_du ? "!" : " ",
-		-1);
-	g_free(str_num);
-	g_free(str_prof);
+static gchar *domain_model_domain_name(struct ccs_domain_policy3 *dp,
+				gint index, gint *redirect_index)
+{
+	const struct ccs_transition_control_entry *transition_control;
+	const gchar	*name;
+	gchar		*line = NULL, *is_dis = NULL, *domain;
 
-	transition_control = dp->list[*index].d_t;
-	if (transition_control && !is_jump_source(dp, *index)) {
-		line = g_strdup_printf(" ( %s%s from %s )",
-			get_transition_name(transition_control->type),
-			transition_control->program ?
-				transition_control->program->name : "any",
-			transition_control->domainname ?
-				transition_control->domainname->name : "any");
-		color =
-		  transition_control->type == CCS_TRANSITION_CONTROL_KEEP ?
-		  "green" : "cyan";
-	} else if (is_jump_source(dp, *index)) {	/* initialize_domain */
-		g_free(name);
-		name = g_strdup(dp->list[*index].target->name);
-		redirect_index = get_find_target_domain(*index);
-		color = "blue";
-		if (redirect_index >= 0)
+	*redirect_index = -1;
+	transition_control = dp->list[index].d_t;
+	if (is_jump_source(dp, index)) {	/* initialize_domain */
+		name = dp->list[index].target->name;
+		*redirect_index = get_find_target_domain(dp, index);
+		if (*redirect_index >= 0)
 			is_dis = g_strdup_printf(" ( -> %d )",
-				       	dp->list[redirect_index].number);
-		else if (redirect_index == EOF)
+				dp->list[*redirect_index].number);
+		else if (*redirect_index == EOF)
 			is_dis = g_strdup_printf(" ( -> Not Found )");
 		else
 			is_dis = g_strdup_printf(" ( -> Namespace jump )");
-	} else if (dp->list[*index].is_dd) {	/* delete_domain */
-		color = "gray";
+	} else {
+		name = get_display_name(get_domain_last_name(dp, index));
+		if (transition_control)
+			line = g_strdup_printf(" ( %s%s from %s )",
+				get_transition_name(transition_control->type),
+				transition_control->program ?
+				transition_control->program->name : "any",
+				transition_control->domainname ?
+				transition_control->domainname->name : "any");
 	}
 	domain = g_strdup_printf("%s%s%s%s%s%s",
-			dp->list[*index].is_dd ? "( " : "",
-			is_jump_source(dp, *index) ? "=> " : "",
+			dp->list[index].is_dd ? "( " : "",
+			is_jump_source(dp, index) ? "=> " : "",
 			name,
-			dp->list[*index].is_dd ? " )" : "",
+			dp->list[index].is_dd ? " )" : "",
 			line ? line : "",
 			is_dis ? is_dis : ""
 			);
-	gtk_tree_store_set(store, &iter, COLUMN_DOMAIN_NAME, domain,
-					 COLUMN_COLOR, color,
-					 COLUMN_REDIRECT, redirect_index, -1);
-	g_free(name);
 	g_free(line);
 	g_free(is_dis);
-	g_free(domain);
+	return domain;
+}
+
+static const gchar *domain_model_color(struct ccs_domain_policy3 *dp,
+							gint index)
+{
+	const struct ccs_transition_control_entry *transition_control;
 
-	(*index)++;
+	transition_control = dp->list[index].d_t;
+	if (transition_control && !is_jump_source(dp, index))
+		return transition_control->type ==
+			CCS_TRANSITION_CONTROL_KEEP ? "green" : "cyan";
+	if (is_jump_source(dp, index))
+		return "blue";
+	if (dp->list[index].is_dd)
+		return "gray";
+	return "black";
+}
 
-	while (*index < dp->list_len) {
-		sp = get_domain_name(dp, *index);
-		for (n = 0; ; n++) {
-			const char *cp = strchr(sp, ' ');
-			if (!cp)
-				break;
-			sp = cp + 1;
-		}
+static void domain_model_get_preview_value(DomainModel *model, gint index,
+						gint column, GValue *value)
+{
+	const gchar	*name = g_ptr_array_index(model->preview,
+						index - model->count);
 
-		if (n > nest)
-			n = add_tree_store(store, &iter, dp, index, n);
-		else
-			break;
+	switch (column) {
+	case COLUMN_INDEX:
+	case COLUMN_REDIRECT:
+		g_value_set_int(value, -1);
+		break;
+	case COLUMN_DOMAIN_NAME:
+		g_value_set_string(value, get_display_text(name));
+		break;
+	case COLUMN_COLOR:
+		g_value_set_static_string(value, "black");
+		break;
+	default:
+		g_value_set_static_string(value, "");
+		break;
+	}
+}
+
+static void domain_model_get_value(GtkTreeModel *tree_model,
+			GtkTreeIter *iter, gint column, GValue *value)
+{
+	DomainModel	*model = DOMAIN_MODEL(tree_model);
+	struct ccs_domain_policy3	*dp = model->dp;
+	gint		index = ITER_INDEX(iter);
+	gint		number, redirect_index;
+
+	g_value_init(value,
+		domain_model_get_column_type(tree_model, column));
+	g_return_if_fail(iter->stamp == model->stamp);
+	if (index >= model->count) {
+		domain_model_get_preview_value(model, index, column, value);
+		return;
 	}
+	number = dp->list[index].number;
 
-	return n;
+	switch (column) {
+	case COLUMN_INDEX:
+		g_value_set_int(value, index);
+		break;
+	case COLUMN_NUMBER:
+		g_value_take_string(value, number >= 0 ?
+			g_strdup_printf("%4d", number) : g_strdup(""));
+		break;
+	case COLUMN_COLON:
+		g_value_set_static_string(value, number >= 0 ? ":" : "");
+		break;
+	case COLUMN_PROFILE:
+		g_value_take_string(value, number >= 0 ?
+			g_strdup_printf("%3u", dp->list[index].profile) :
+			g_strdup(""));
+		break;
+	case COLUMN_KEEPER_DOMAIN:
+		g_value_set_static_string(value,
+				dp->list[index].is_dk ? "#" : " ");
+		break;
+	case COLUMN_INITIALIZER_TARGET:
+		g_value_set_static_string(value,
+				dp->list[index].is_djt ? "*" : " ");
+		break;
+	case COLUMN_DOMAIN_UNREACHABLE:
+		g_value_set_static_string(value,
+				dp->list[index].is_du ? "!" : " ");
+		break;
+	case COLUMN_DOMAIN_NAME:
+		g_value_take_string(value,
+			domain_model_domain_name(dp, index, &redirect_index));
+		break;
+	case COLUMN_COLOR:
+		g_value_set_static_string(value,
+				domain_model_color(dp, index));
+		break;
+	case COLUMN_REDIRECT:
+		g_value_set_int(value, is_jump_source(dp, index) ?
+				get_find_target_domain(dp, index) : -1);
+		break;
+	}
+}
+
+static gboolean domain_model_iter_next(GtkTreeModel *tree_model,
+							GtkTreeIter *iter)
+{
+	DomainModel	*model = DOMAIN_MODEL(tree_model);
+	gint		index = ITER_INDEX(iter);
+
+	if (index >= model->count)
+		return domain_model_set_iter(model, iter, index + 1);
+	return domain_model_set_iter(model, iter,
+		domain_model_nth_child(model, model->parent_row[index],
+					model->nth[index] + 1));
 }
 
+static gboolean domain_model_iter_nth_child(GtkTreeModel *tree_model,
+		GtkTreeIter *iter, GtkTreeIter *parent, gint n)
+{
+	DomainModel	*model = DOMAIN_MODEL(tree_model);
+
+	return domain_model_set_iter(model, iter,
+		domain_model_nth_child(model,
+			parent ? ITER_INDEX(parent) : -1, n));
+}
+
+static gboolean domain_model_iter_children(GtkTreeModel *tree_model,
+				GtkTreeIter *iter, GtkTreeIter *parent)
+{
+	return domain_model_iter_nth_child(tree_model, iter, parent, 0);
+}
+
+static gint domain_model_iter_n_children(GtkTreeModel *tree_model,
+							GtkTreeIter *iter)
+{
+	DomainModel	*model = DOMAIN_MODEL(tree_model);
+
+	if (!iter)
+		return model->n_roots + domain_model_n_preview(model);
+	if (ITER_INDEX(iter) >= model->count)
+		return 0;
+	return model->n_children[ITER_INDEX(iter)];
+}
+
+static gboolean domain_model_iter_has_child(GtkTreeModel *tree_model,
+							GtkTreeIter *iter)
+{
+	return domain_model_iter_n_children(tree_model, iter) > 0;
+}
+
+static gboolean domain_model_iter_parent(GtkTreeModel *tree_model,
+				GtkTreeIter *iter, GtkTreeIter *child)
+{
+	DomainModel	*model = DOMAIN_MODEL(tree_model);
+	gint		index = ITER_INDEX(child);
+
+	return domain_model_set_iter(model, iter, index < model->count ?
+					model->parent_row[index] : -1);
+}
+
+static void domain_model_tree_model_init(GtkTreeModelIface *iface)
+{
+	iface->get_flags = domain_model_get_flags;
+	iface->get_n_columns = domain_model_get_n_columns;
+	iface->get_column_type = domain_model_get_column_type;
+	iface->get_iter = domain_model_get_iter;
+	iface->get_path = domain_model_get_path;
+	iface->get_value = domain_model_get_value;
+	iface->iter_next = domain_model_iter_next;
+	iface->iter_children = domain_model_iter_children;
+	iface->iter_has_child = domain_model_iter_has_child;
+	iface->iter_n_children = domain_model_iter_n_children;
+	iface->iter_nth_child = domain_model_iter_nth_child;
+	iface->iter_parent = domain_model_iter_parent;
+}
+
+static void get_font_widths(GtkWidget *view,
+				gint *char_width, gint *digit_width)
+{
+	PangoFontMetrics	*metrics;
+
+	metrics = pango_context_get_metrics(gtk_widget_get_pango_context(view),
+				view->style->font_desc, NULL);
+	*char_width = PANGO_PIXELS(
+			pango_font_metrics_get_approximate_char_width(metrics));
+	*digit_width = PANGO_PIXELS(
+			pango_font_metrics_get_approximate_digit_width(metrics));
+	pango_font_metrics_unref(metrics);
+}
+
+/* Upper bound of the length of domain_model_domain_name(). */
+static gint domain_model_domain_name_len(struct ccs_domain_policy3 *dp,
+							gint index)
+{
+	const struct ccs_transition_control_entry *transition_control;
+	gint		len = dp->list[index].is_dd ? 4 : 0;
+
+	if (is_jump_source(dp, index))
+		return len + 3 + dp->list[index].target->total_len +
+					strlen(" ( -> Namespace jump )");
+	len += strlen(get_domain_last_name(dp, index));
+	transition_control = dp->list[index].d_t;
+	if (transition_control)
+		len += strlen(" (  from  )") +
+			strlen(get_transition_name(transition_control->type)) +
+			(transition_control->program ?
+			 transition_control->program->total_len : 3) +
+			(transition_control->domainname ?
+			 transition_control->domainname->total_len : 3);
+	return len;
+}
+
+/*
+ * With fixed height mode every column needs a fixed width. As for the list
+ * views, estimate it from the raw strings instead of measuring each row.
+ * @len is the length of the longest domain name, or -1 to compute it.
+ */
+static void set_domain_column_width(GtkTreeView *view, DomainModel *model,
+								gint len)
+{
+	GList		*columns, *list;
+	gint		char_width, digit_width, expander_size;
+	gint		name_width = 0, column, i, width;
+
+	get_font_widths(GTK_WIDGET(view), &char_width, &digit_width);
+	gtk_widget_style_get(GTK_WIDGET(view),
+				"expander-size", &expander_size, NULL);
+	expander_size += 4;	// EXPANDER_EXTRA_PADDING of GtkTreeView
+	if (len >= 0)
+		name_width = expander_size + len * char_width;
+	for (i = 0; len < 0 && i < model->count; i++) {
+		width = (get_domain_depth(model->dp, i) + 1) * expander_size +
+			domain_model_domain_name_len(model->dp, i) *
+								char_width;
+		if (width > name_width)
+			name_width = width;
+	}
+
+	columns = gtk_tree_view_get_columns(view);
+	for (list = columns, column = COLUMN_NUMBER; list;
+	     list = g_list_next(list), column++) {
+		switch (column) {
+		case COLUMN_NUMBER :
+			len = 4;
+			for (i = 10000; i <= model->count; i *= 10)
+				len++;
+			width = len * digit_width;
+			break;
+		case COLUMN_PROFILE :
+			width = 3 * digit_width;
+			break;
+		case COLUMN_DOMAIN_NAME :
+			width = name_width;
+			break;
+		default :
+			width = char_width;
+			break;
+		}
+		gtk_tree_view_column_set_fixed_width(list->data,
+						MAX(width, 1) + 8);
+	}
+	g_list_free(columns);
+}
+
+/* A new model shows every row collapsed, so the tree is expanded here. */
 void add_tree_data(GtkTreeView *treeview, struct ccs_domain_policy3 *dp)
 {
-	GtkTreeStore	*store;
-	GtkTreeIter	*iter = NULL;
-	int		index = 0, nest = -1;
+	GtkTreeModel	*model;
+
+	/* Replacing the model is cheaper than removing every row. */
+	model = domain_model_new(dp);
+	set_domain_column_width(treeview, DOMAIN_MODEL(model), -1);
+	gtk_tree_view_set_model(treeview, model);
+	g_object_unref(model);
+	gtk_tree_view_expand_all(treeview);
+}
+
+void update_tree_data(GtkTreeView *treeview, struct ccs_domain_policy3 *dp)
+{
+	GtkTreeModel	*model;
+	GtkTreeIter	iter;
+	GtkTreePath	*path;
+	const int	*list;
+	int		count, i;
 
-	store = GTK_TREE_STORE(gtk_tree_view_get_model(treeview));
-	gtk_tree_store_clear(store);	// TODO 遅い
-	if (dp->list_len > 0)
-		add_tree_store(store, iter, dp, &index, nest);
+	model = gtk_tree_view_get_model(treeview);
+	count = get_changed_domains(&list);
+	if (count == EOF || !IS_DOMAIN_MODEL(model) ||
+	    DOMAIN_MODEL(model)->dp != dp || DOMAIN_MODEL(model)->preview) {
+		add_tree_data(treeview, dp);
+		return;
+	}
+
+	/* Values are read on demand; only tell the view what to redraw. */
+	for (i = 0; i < count; i++) {
+		domain_model_set_iter(DOMAIN_MODEL(model), &iter, list[i]);
+		path = gtk_tree_model_get_path(model, &iter);
+		gtk_tree_model_row_changed(model, path, &iter);
+		gtk_tree_path_free(path);
+	}
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Adds a row for @domainname to the domain view's DomainModel while the
+ * domain policy is still being read (see loader.c). Only the full
+ * domainname is shown; the numbers and the tree appear when the model is
+ * replaced by update_tree_data().
+ */
+void add_preview_row(GtkTreeView *treeview, const char *domainname)
+{
+	GtkTreeModel	*tree_model = gtk_tree_view_get_model(treeview);
+	DomainModel	*model = DOMAIN_MODEL(tree_model);
+	GtkTreeIter	iter;
+	GtkTreePath	*path;
+	gint		len = strlen(domainname);
+
+	if (len > model->preview_len) {
+		model->preview_len = len;
+		set_domain_column_width(treeview, model, len);
+	}
+	if (!model->preview)
+		model->preview = g_ptr_array_new();
+	g_ptr_array_add(model->preview, g_strdup(domainname));
+	domain_model_set_iter(model, &iter,
+			model->count + model->preview->len - 1);
+	path = gtk_tree_model_get_path(tree_model, &iter);
+	gtk_tree_model_row_inserted(tree_model, path, &iter);
+	gtk_tree_path_free(path);
 }
 /*---------------------------------------------------------------------------*/
 static GtkTreeViewColumn *column_add(
@@ -227,6 +765,7 @@ static GtkTreeViewColumn *column_add(
 	gtk_tree_view_column_add_attribute(column, renderer,
 		       			"foreground", COLUMN_COLOR);
 //	gtk_tree_view_column_set_alignment(column, xalign);
+	gtk_tree_view_column_set_sizing(column, GTK_TREE_VIEW_COLUMN_FIXED);
 	gtk_tree_view_append_column(GTK_TREE_VIEW(treeview), column);
 
 	return column;
@@ -256,23 +795,13 @@ static void cb_status_toggled(GtkCellRendererToggle	*renderer,
 static GtkWidget *create_tree_model(void)
 {
 	GtkWidget		*treeview;
-	GtkTreeStore		*store;
+	GtkTreeModel		*model;
 //	GtkCellRenderer	*renderer;
 	GtkTreeViewColumn	*column;
 
-	store = gtk_tree_store_new(N_COLUMNS_TREE,
-				G_TYPE_INT,
-				G_TYPE_STRING,
-				G_TYPE_STRING,
-				G_TYPE_STRING,
-				G_TYPE_STRING,
-				G_TYPE_STRING,
-				G_TYPE_STRING,
-				G_TYPE_STRING,
-				G_TYPE_STRING,
-				G_TYPE_INT);
-	treeview = gtk_tree_view_new_with_model(GTK_TREE_MODEL(store));
-	g_object_unref(store);
+	model = domain_model_new(NULL);
+	treeview = gtk_tree_view_new_with_model(model);
+	g_object_unref(model);
 
 // TODO refactoring
 //	renderer = gtk_cell_renderer_toggle_new();
@@ -303,6 +832,8 @@ static GtkWidget *create_tree_model(void)
 //	gtk_tree_view_column_set_spacing(column, 1);
 	// ヘッダ非表示
 	gtk_tree_view_set_headers_visible(GTK_TREE_VIEW(treeview), FALSE);
+	// 行の高さを固定し、見えている行だけ描画する
+	gtk_tree_view_set_fixed_height_mode(GTK_TREE_VIEW(treeview), TRUE);
 
 	return treeview;
 }
@@ -315,61 +846,432 @@ enum list_column_pos {
 	N_COLUMNS_LIST
 };
 
-void add_list_data(generic_list_t *generic, 
-			enum ccs_screen_type current_page)
+/*
+ * ListModel is a flat GtkTreeModel over a "generic_list_t". Nothing is
+ * copied when a list is shown; the text of a row is made by the cell data
+ * functions only for the rows the view actually draws.
+ *
+ * "order" maps a row to an index in generic->list and "row" is its inverse;
+ * they are the only per-row storage and are permuted in place when the user
+ * sorts by a column. A GtkTreeIter holds the index in generic->list in
+ * user_data, so that iters stay valid across sorting.
+ */
+typedef struct _ListModel {
+	GObject		parent;
+	gint		stamp;
+	generic_list_t	*generic;
+	enum ccs_screen_type	type;
+	gint		count;
+	gint		*order;		// row -> index in generic->list
+	gint		*row;		// index in generic->list -> row
+	gint		sort_column;
+	GtkSortType	sort_order;
+} ListModel;
+
+typedef struct _ListModelClass {
+	GObjectClass	parent_class;
+} ListModelClass;
+
+static void list_model_tree_model_init(GtkTreeModelIface *iface);
+static void list_model_sortable_init(GtkTreeSortableIface *iface);
+
+G_DEFINE_TYPE_WITH_CODE(ListModel, list_model, G_TYPE_OBJECT,
+	G_IMPLEMENT_INTERFACE(GTK_TYPE_TREE_MODEL,
+				list_model_tree_model_init)
+	G_IMPLEMENT_INTERFACE(GTK_TYPE_TREE_SORTABLE,
+				list_model_sortable_init))
+
+#define LIST_MODEL(obj) \
+	(G_TYPE_CHECK_INSTANCE_CAST((obj), list_model_get_type(), ListModel))
+#define IS_LIST_MODEL(obj) \
+	(G_TYPE_CHECK_INSTANCE_TYPE((obj), list_model_get_type()))
+
+static void list_model_init(ListModel *model)
 {
-	GtkListStore	*store;
-	GtkTreeIter	iter;
-	int		i;
-	gchar		*str_num, *ope, *profile, *alias;
+	model->stamp = g_random_int();
+	model->sort_column = GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID;
+	model->sort_order = GTK_SORT_ASCENDING;
+}
+
+static void list_model_finalize(GObject *object)
+{
+	g_free(LIST_MODEL(object)->order);
+	g_free(LIST_MODEL(object)->row);
+	G_OBJECT_CLASS(list_model_parent_class)->finalize(object);
+}
 
-	store = GTK_LIST_STORE(gtk_tree_view_get_model(
-				GTK_TREE_VIEW(generic->listview)));
+static void list_model_class_init(ListModelClass *klass)
+{
+	G_OBJECT_CLASS(klass)->finalize = list_model_finalize;
+}
+
+static GtkTreeModel *list_model_new(generic_list_t *generic,
+					enum ccs_screen_type type)
+{
+	ListModel	*model = g_object_new(list_model_get_type(), NULL);
+	gint		i;
+
+	model->generic = generic;
+	model->type = type;
+	model->count = generic ? generic->count : 0;
+	model->order = g_new(gint, model->count);
+	model->row = g_new(gint, model->count);
+	for (i = 0; i < model->count; i++)
+		model->order[i] = model->row[i] = i;
+	return GTK_TREE_MODEL(model);
+}
+
+/* Returns the index in generic->list shown at @iter, or -1. */
+static gint list_model_index(ListModel *model, GtkTreeIter *iter)
+{
+	gint	index = ITER_INDEX(iter);
 
-	gtk_list_store_clear(store);
-	for(i = 0; i < generic->count; i++){
-		str_num = g_strdup_printf("%4d", i);
-		gtk_list_store_append(store, &iter);
+	if (iter->stamp != model->stamp || index < 0 ||
+	    index >= model->count || index >= model->generic->count)
+		return -1;
+	return index;
+}
 
-		switch((int)current_page) {
+/* Returns a newly allocated string of @column for generic->list[@index]. */
+static gchar *list_model_text(ListModel *model, gint index, gint column)
+{
+	struct ccs_generic_acl	*acl = &model->generic->list[index];
+
+	switch (column) {
+	case LIST_NUMBER :
+		return g_strdup_printf("%4d", index);
+	case LIST_COLON :
+		return g_strdup(":");
+	case LIST_ALIAS :
+		if (model->type == CCS_SCREEN_EXCEPTION_LIST ||
+		    model->type == CCS_SCREEN_ACL_LIST)
+			return g_strdup(ccs_directives[acl->directive].alias);
+		break;
+	case LIST_OPERAND :
+		switch ((int)model->type) {
 		case CCS_SCREEN_EXCEPTION_LIST :
 		case CCS_SCREEN_ACL_LIST :
-			ope = decode_from_octal_str(generic->list[i].operand);
-			alias = (gchar *)
-			  ccs_directives[generic->list[i].directive].alias;
-			gtk_list_store_set(store, &iter,
-					LIST_NUMBER, str_num,
-					LIST_COLON,  ":",
-					LIST_ALIAS, alias,
-					LIST_OPERAND, ope,
-					-1);
-			g_free(ope);
-			break;
+			return g_strdup(get_display_text(acl->operand));
 		case CCS_SCREEN_PROFILE_LIST :
-			profile = g_strdup_printf("%3u-",
-					generic->list[i].directive);
-			alias = g_strdup_printf("%s%s",
-					generic->list[i].directive < 256 ?
-					profile : "",
-					generic->list[i].operand);
-			gtk_list_store_set(store, &iter,
-					LIST_NUMBER, str_num,
-					LIST_COLON,  ":",
-					LIST_OPERAND, alias,
-					-1);
-			g_free(profile);
-			g_free(alias);
-			break;
+			if (acl->directive < 256)
+				return g_strdup_printf("%3u-%s",
+						acl->directive, acl->operand);
+			return g_strdup(acl->operand);
 		case CCS_SCREEN_NS_LIST :
-			gtk_list_store_set(store, &iter,
-					LIST_NUMBER, str_num,
-					LIST_COLON,  ":",
-					LIST_OPERAND, generic->list[i].operand,
-					-1);
+			return g_strdup(acl->operand);
+		}
+		break;
+	}
+	return NULL;
+}
+
+static GtkTreeModelFlags list_model_get_flags(GtkTreeModel *tree_model)
+{
+	return GTK_TREE_MODEL_ITERS_PERSIST | GTK_TREE_MODEL_LIST_ONLY;
+}
+
+static gint list_model_get_n_columns(GtkTreeModel *tree_model)
+{
+	return N_COLUMNS_LIST;
+}
+
+static GType list_model_get_column_type(GtkTreeModel *tree_model,
+					gint column)
+{
+	return G_TYPE_STRING;
+}
+
+static gboolean list_model_set_iter(ListModel *model,
+					GtkTreeIter *iter, gint row)
+{
+	if (row < 0 || row >= model->count) {
+		iter->stamp = 0;
+		return FALSE;
+	}
+	iter->stamp = model->stamp;
+	iter->user_data = GINT_TO_POINTER(model->order[row]);
+	return TRUE;
+}
+
+static gboolean list_model_get_iter(GtkTreeModel *tree_model,
+				GtkTreeIter *iter, GtkTreePath *path)
+{
+	if (gtk_tree_path_get_depth(path) != 1)
+		return FALSE;
+	return list_model_set_iter(LIST_MODEL(tree_model), iter,
+				gtk_tree_path_get_indices(path)[0]);
+}
+
+static GtkTreePath *list_model_get_path(GtkTreeModel *tree_model,
+					GtkTreeIter *iter)
+{
+	ListModel	*model = LIST_MODEL(tree_model);
+	GtkTreePath	*path;
+
+	g_return_val_if_fail(iter->stamp == model->stamp, NULL);
+	path = gtk_tree_path_new();
+	gtk_tree_path_append_index(path, model->row[ITER_INDEX(iter)]);
+	return path;
+}
+
+static void list_model_get_value(GtkTreeModel *tree_model,
+			GtkTreeIter *iter, gint column, GValue *value)
+{
+	ListModel	*model = LIST_MODEL(tree_model);
+	gint		index = list_model_index(model, iter);
+
+	g_value_init(value, G_TYPE_STRING);
+	if (index >= 0)
+		g_value_take_string(value,
+				list_model_text(model, index, column));
+}
+
+static gboolean list_model_iter_next(GtkTreeModel *tree_model,
+					GtkTreeIter *iter)
+{
+	ListModel	*model = LIST_MODEL(tree_model);
+
+	return list_model_set_iter(model, iter,
+					model->row[ITER_INDEX(iter)] + 1);
+}
+
+static gboolean list_model_iter_nth_child(GtkTreeModel *tree_model,
+		GtkTreeIter *iter, GtkTreeIter *parent, gint n)
+{
+	if (parent) {
+		iter->stamp = 0;
+		return FALSE;
+	}
+	return list_model_set_iter(LIST_MODEL(tree_model), iter, n);
+}
+
+static gboolean list_model_iter_children(GtkTreeModel *tree_model,
+				GtkTreeIter *iter, GtkTreeIter *parent)
+{
+	return list_model_iter_nth_child(tree_model, iter, parent, 0);
+}
+
+static gboolean list_model_iter_has_child(GtkTreeModel *tree_model,
+					GtkTreeIter *iter)
+{
+	return FALSE;
+}
+
+static gint list_model_iter_n_children(GtkTreeModel *tree_model,
+					GtkTreeIter *iter)
+{
+	return iter ? 0 : LIST_MODEL(tree_model)->count;
+}
+
+static gboolean list_model_iter_parent(GtkTreeModel *tree_model,
+				GtkTreeIter *iter, GtkTreeIter *child)
+{
+	iter->stamp = 0;
+	return FALSE;
+}
+
+static void list_model_tree_model_init(GtkTreeModelIface *iface)
+{
+	iface->get_flags = list_model_get_flags;
+	iface->get_n_columns = list_model_get_n_columns;
+	iface->get_column_type = list_model_get_column_type;
+	iface->get_iter = list_model_get_iter;
+	iface->get_path = list_model_get_path;
+	iface->get_value = list_model_get_value;
+	iface->iter_next = list_model_iter_next;
+	iface->iter_children = list_model_iter_children;
+	iface->iter_has_child = list_model_iter_has_child;
+	iface->iter_n_children = list_model_iter_n_children;
+	iface->iter_nth_child = list_model_iter_nth_child;
+	iface->iter_parent = list_model_iter_parent;
+}
+
+/*
+ * Sorting compares the raw entries, so that no string is made per row.
+ * Octal-escaped operands keep the order of the decoded ones for ASCII.
+ */
+static gint list_model_compare(gconstpointer a, gconstpointer b,
+					gpointer data)
+{
+	ListModel		*model = data;
+	gint			i = *(const gint *)a, j = *(const gint *)b;
+	struct ccs_generic_acl	*x = &model->generic->list[i];
+	struct ccs_generic_acl	*y = &model->generic->list[j];
+	gint			cmp = 0;
+
+	switch (model->sort_column) {
+	case LIST_ALIAS :
+		cmp = strcmp(ccs_directives[x->directive].alias,
+				ccs_directives[y->directive].alias);
+		break;
+	case LIST_OPERAND :
+		if (model->type == CCS_SCREEN_PROFILE_LIST)
+			cmp = x->directive < y->directive ? -1 :
+				x->directive > y->directive;
+		if (!cmp)
+			cmp = strcmp(x->operand, y->operand);
+		break;
+	}
+	if (!cmp)
+		cmp = i - j;
+	return model->sort_order == GTK_SORT_DESCENDING ? -cmp : cmp;
+}
+
+static void list_model_sort(ListModel *model)
+{
+	GtkTreePath	*path;
+	gint		*new_order;
+	gint		i;
+
+	if (model->count < 2)
+		return;
+	g_qsort_with_data(model->order, model->count, sizeof(gint),
+				list_model_compare, model);
+	new_order = g_new(gint, model->count);
+	for (i = 0; i < model->count; i++) {
+		new_order[i] = model->row[model->order[i]];
+		model->row[model->order[i]] = i;
+	}
+
+	path = gtk_tree_path_new();
+	gtk_tree_model_rows_reordered(GTK_TREE_MODEL(model),
+						path, NULL, new_order);
+	gtk_tree_path_free(path);
+	g_free(new_order);
+}
+
+static gboolean list_model_get_sort_column_id(GtkTreeSortable *sortable,
+				gint *sort_column_id, GtkSortType *order)
+{
+	ListModel	*model = LIST_MODEL(sortable);
+
+	if (sort_column_id)
+		*sort_column_id = model->sort_column;
+	if (order)
+		*order = model->sort_order;
+	return model->sort_column != GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID &&
+	       model->sort_column != GTK_TREE_SORTABLE_DEFAULT_SORT_COLUMN_ID;
+}
+
+static void list_model_set_sort_column_id(GtkTreeSortable *sortable,
+				gint sort_column_id, GtkSortType order)
+{
+	ListModel	*model = LIST_MODEL(sortable);
+
+	if (sort_column_id == GTK_TREE_SORTABLE_DEFAULT_SORT_COLUMN_ID)
+		sort_column_id = GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID;
+	if (model->sort_column == sort_column_id &&
+	    model->sort_order == order)
+		return;
+	model->sort_column = sort_column_id;
+	model->sort_order = order;
+	gtk_tree_sortable_sort_column_changed(sortable);
+	list_model_sort(model);
+}
+
+static gboolean list_model_has_default_sort_func(GtkTreeSortable *sortable)
+{
+	return FALSE;
+}
+
+static void list_model_sortable_init(GtkTreeSortableIface *iface)
+{
+	iface->get_sort_column_id = list_model_get_sort_column_id;
+	iface->set_sort_column_id = list_model_set_sort_column_id;
+	iface->has_default_sort_func = list_model_has_default_sort_func;
+}
+
+static void list_cell_data(GtkTreeViewColumn *column,
+		GtkCellRenderer *renderer, GtkTreeModel *tree_model,
+		GtkTreeIter *iter, gpointer data)
+{
+	ListModel	*model = LIST_MODEL(tree_model);
+	gint		index = list_model_index(model, iter);
+	gchar		*text;
+
+	if (index < 0) {
+		g_object_set(renderer, "text", NULL, NULL);
+		return;
+	}
+	text = list_model_text(model, index, GPOINTER_TO_INT(data));
+	g_object_set(renderer, "text", text, NULL);
+	g_free(text);
+}
+
+/*
+ * With fixed height mode every column needs a fixed width. Estimate it from
+ * the longest raw entry instead of measuring each row with Pango.
+ */
+static void set_list_column_width(GtkWidget *view, ListModel *model)
+{
+	GList		*columns, *list;
+	gint		char_width, digit_width;
+	gint		max_alias = 0, max_operand = 0, i, len;
+
+	get_font_widths(view, &char_width, &digit_width);
+
+	for (i = 0; i < model->count; i++) {
+		struct ccs_generic_acl	*acl = &model->generic->list[i];
+
+		len = strlen(acl->operand);
+		if (model->type == CCS_SCREEN_PROFILE_LIST)
+			len += 4;
+		if (len > max_operand)
+			max_operand = len;
+		if (model->type != CCS_SCREEN_EXCEPTION_LIST &&
+		    model->type != CCS_SCREEN_ACL_LIST)
+			continue;
+		len = strlen(ccs_directives[acl->directive].alias);
+		if (len > max_alias)
+			max_alias = len;
+	}
+
+	columns = gtk_tree_view_get_columns(GTK_TREE_VIEW(view));
+	for (list = columns; list; list = g_list_next(list)) {
+		GtkTreeViewColumn *column = list->data;
+		gint	width = 0;
+
+		switch (gtk_tree_view_column_get_sort_column_id(column)) {
+		case LIST_NUMBER :
+			len = 4;
+			for (i = 10000; i <= model->count; i *= 10)
+				len++;
+			width = len * digit_width;
+			break;
+		case LIST_ALIAS :
+			width = max_alias * char_width;
+			break;
+		case LIST_OPERAND :
+			width = max_operand * char_width;
 			break;
+		default :
+			continue;
 		}
-		g_free(str_num);
+		gtk_tree_view_column_set_fixed_width(column,
+						MAX(width, 1) + 8);
 	}
+	g_list_free(columns);
+}
+
+void add_list_data(generic_list_t *generic, 
+			enum ccs_screen_type current_page)
+{
+	GtkTreeView	*view = GTK_TREE_VIEW(generic->listview);
+	GtkTreeModel	*old = gtk_tree_view_get_model(view);
+	GtkTreeModel	*model;
+	gint		sort_column;
+	GtkSortType	order;
+
+	// 新しいモデルに差し替え、ソート順だけ引き継ぐ
+	model = list_model_new(generic, current_page);
+	if (old && IS_LIST_MODEL(old) &&
+	    gtk_tree_sortable_get_sort_column_id(GTK_TREE_SORTABLE(old),
+						&sort_column, &order))
+		gtk_tree_sortable_set_sort_column_id(
+			GTK_TREE_SORTABLE(model), sort_column, order);
+	set_list_column_width(generic->listview, LIST_MODEL(model));
+	gtk_tree_view_set_model(view, model);
+	g_object_unref(model);
 }
 
 static void disable_header_focus(GtkTreeViewColumn *column, const gchar *str)
@@ -393,49 +1295,58 @@ static void disable_header_focus(GtkTreeViewColumn *column, const gchar *str)
 //	g_print("\n");
 }
 
+static GtkTreeViewColumn *list_column_add(GtkWidget *treeview,
+			GtkCellRenderer *renderer, const gchar *title,
+			gint column_id)
+{
+	GtkTreeViewColumn	*column;
+
+	column = gtk_tree_view_column_new();
+	gtk_tree_view_column_set_title(column, title);
+	gtk_tree_view_column_pack_start(column, renderer, TRUE);
+	gtk_tree_view_column_set_cell_data_func(column, renderer,
+			list_cell_data, GINT_TO_POINTER(column_id), NULL);
+	gtk_tree_view_column_set_sizing(column, GTK_TREE_VIEW_COLUMN_FIXED);
+	gtk_tree_view_column_set_resizable(column, TRUE);
+	gtk_tree_view_append_column(GTK_TREE_VIEW(treeview), column);
+	disable_header_focus(column, title);
+	return column;
+}
+
 static GtkWidget *create_list_model(gboolean alias_flag)
 {
 	GtkWidget		*treeview;
-	GtkListStore		*liststore;
+	GtkTreeModel		*model;
 	GtkCellRenderer	*renderer;
 	GtkTreeViewColumn	*column;
 
-	liststore = gtk_list_store_new(N_COLUMNS_LIST,
-				  G_TYPE_STRING, G_TYPE_STRING,
-				  G_TYPE_STRING, G_TYPE_STRING);
-	treeview = gtk_tree_view_new_with_model(GTK_TREE_MODEL(liststore));
-	g_object_unref(liststore);
+	model = list_model_new(NULL, CCS_SCREEN_ACL_LIST);
+	treeview = gtk_tree_view_new_with_model(model);
+	g_object_unref(model);
 
 	renderer = gtk_cell_renderer_text_new();
 	g_object_set(renderer, "xalign", 1.0, "ypad", 0, NULL);
-	column = gtk_tree_view_column_new_with_attributes(
-			"No.", renderer, "text", LIST_NUMBER, NULL);
-	gtk_tree_view_append_column(GTK_TREE_VIEW(treeview), column);
+	column = list_column_add(treeview, renderer, "No.", LIST_NUMBER);
 	gtk_tree_view_column_set_sort_column_id(column, LIST_NUMBER);
 //	gtk_tree_view_column_set_alignment(column, 1.0);
-	disable_header_focus(column, "No.");
 
 	renderer = gtk_cell_renderer_text_new();
-	column = gtk_tree_view_column_new_with_attributes(" ", renderer,
-					      "text", LIST_COLON, NULL);
-	gtk_tree_view_append_column(GTK_TREE_VIEW(treeview), column);
-	disable_header_focus(column, " ");
+	column = list_column_add(treeview, renderer, " ", LIST_COLON);
+	gtk_tree_view_column_set_fixed_width(column, 12);
 
 	if (alias_flag) {
 		renderer = gtk_cell_renderer_text_new();
-		column = gtk_tree_view_column_new_with_attributes(
-			"directive", renderer, "text", LIST_ALIAS, NULL);
-		gtk_tree_view_append_column(GTK_TREE_VIEW(treeview), column);
+		column = list_column_add(treeview, renderer,
+					"directive", LIST_ALIAS);
 		gtk_tree_view_column_set_sort_column_id(column, LIST_ALIAS);
-		disable_header_focus(column, "directive");
 	}
 
 	renderer = gtk_cell_renderer_text_new();
-	column = gtk_tree_view_column_new_with_attributes("operand", renderer,
-					      "text", LIST_OPERAND, NULL);
-	gtk_tree_view_append_column(GTK_TREE_VIEW(treeview), column);
+	column = list_column_add(treeview, renderer, "operand", LIST_OPERAND);
 	gtk_tree_view_column_set_sort_column_id(column, LIST_OPERAND);
-	disable_header_focus(column, "operand");
+
+	// 行の高さを固定し、見えている行だけ描画する
+	gtk_tree_view_set_fixed_height_mode(GTK_TREE_VIEW(treeview), TRUE);
 
 	// ヘッダ表示
 //	gtk_tree_view_set_headers_visible(GTK_TREE_VIEW(treeview), TRUE);
@@ -515,9 +1426,10 @@ static gboolean move_pos_list(GtkTreeModel *model, GtkTreePath *path,
 	case ADDENTRY_DOMAIN_LIST :
 		view = transition->treeview;
 		gtk_tree_model_get(model, iter, COLUMN_INDEX, &index, -1);
-		str_buff = decode_from_octal_str(
-					get_domain_name(transition->dp, index));
-		cmp = strcmp(entry, str_buff);
+		if (index < 0)	/* a preview row */
+			break;
+		cmp = strcmp(entry, get_display_name(
+				get_domain_name(transition->dp, index)));
 		break;
 	case ADDENTRY_ACL_LIST :
 		view = transition->acl.listview;
@@ -620,6 +1532,41 @@ void set_position_addentry(transition_t *transition, GtkTreePath **path)
 #endif
 }
 /*---------------------------------------------------------------------------*/
+static gint load_acl(load_job_t *job)
+{
+	return get_acl_list(&(job->dp), job->index,
+				&(job->list), &(job->count));
+}
+
+static void show_acl(load_job_t *job)
+{
+	transition_t		*transition = job->transition;
+	struct ccs_generic_acl	*list = transition->acl.list;
+	int			count = transition->acl.count;
+
+	*(transition->dp) = job->dp;
+	if (job->cancelled)	// selected another domain
+		return;
+	// swap; the old list is freed with the job
+	transition->acl.list = job->list;
+	transition->acl.count = job->count;
+	job->list = list;
+	job->count = count;
+	add_list_data(&(transition->acl), CCS_SCREEN_ACL_LIST);
+
+	if (transition->acl.count) {
+		set_position_addentry(transition, &(job->path));
+		DEBUG_PRINT("ACL count<%d>\n", transition->acl.count);
+		DEBUG_PRINT("ACL ");
+		view_cursor_set(job->view, job->path, job->column);
+		job->path = NULL;
+//		gtk_widget_grab_focus(transition->acl.listview);
+		disp_statusbar(transition, CCS_SCREEN_ACL_LIST);
+	} else {	/* delete_domain or initializer_source */
+		disp_statusbar(transition, CCS_MAXSCREEN);
+	}
+}
+
 static void cb_selection(GtkTreeSelection *selection,
 				transition_t *transition)
 {
@@ -628,9 +1575,8 @@ static void cb_selection(GtkTreeSelection *selection,
 	GtkTreeModel		*model;
 	GList			*list;
 	gint			index;
-	GtkTreePath		*path = NULL;
-	GtkTreeViewColumn	*column = NULL;
 	gchar			*name;
+	load_job_t		*job;
 
 	DEBUG_PRINT("In  **************************** \n");
 	select_count = gtk_tree_selection_count_selected_rows(selection);
@@ -646,7 +1592,10 @@ static void cb_selection(GtkTreeSelection *selection,
 	g_list_free(list);
 	gtk_tree_model_get(model, &iter, COLUMN_INDEX, &index, -1);
 	DEBUG_PRINT("--- index [%4d] ---\n", index);
-	name = decode_from_octal_str(get_domain_name(transition->dp, index));
+	if (index < 0)	/* a preview row; see add_preview_row() */
+		return;
+	name = g_strdup(get_display_name(
+				get_domain_name(transition->dp, index)));
 	if (is_jump_source(transition->dp, index)) {
 		gchar *cp = strrchr(name, ' ');
 		if (cp)
@@ -655,23 +1604,12 @@ static void cb_selection(GtkTreeSelection *selection,
 	gtk_entry_set_text(GTK_ENTRY(transition->domainbar), name);
 	g_free(name);
 
-	gtk_tree_view_get_cursor(GTK_TREE_VIEW(
-			transition->acl.listview), &path, &column);
-
-	get_acl_list(transition->dp, index,
-		&(transition->acl.list), &(transition->acl.count));
-	add_list_data(&(transition->acl), CCS_SCREEN_ACL_LIST);
-
-	if (transition->acl.count) {
-		set_position_addentry(transition, &path);
-		DEBUG_PRINT("ACL count<%d>\n", transition->acl.count);
-		DEBUG_PRINT("ACL ");
-		view_cursor_set(transition->acl.listview, path, column);
-//		gtk_widget_grab_focus(transition->acl.listview);
-		disp_statusbar(transition, CCS_SCREEN_ACL_LIST);
-	} else {	/* delete_domain or initializer_source */
-		disp_statusbar(transition, CCS_MAXSCREEN);
-	}
+	job = new_load_job(transition, transition->acl.listview,
+					load_acl, show_acl);
+	job->index = index;
+	// Only ccs_gacl_list is read again, which no view reads.
+	job->background = TRUE;
+	start_load_job(job);
 	DEBUG_PRINT("Out **************************** \n");
 }
 /*---------------------------------------------------------------------------*/
@@ -680,6 +1618,27 @@ static void set_ns_tab_label(transition_t *transition,
 {
 	GtkWidget		*notebook;
 	GtkWidget		*tab4;
+	gchar			*old_namespace;
+
+	wait_load_job();
+	if (strcmp(get_ns_name(), namespace)) {
+		old_namespace = g_strdup(get_ns_name());
+		put_ns_name(namespace);
+		// Domains of every namespace are loaded; only pick the
+		// other range. Whether the policy has changed is left to
+		// the next refresh.
+		if (select_domain_namespace(transition->dp,
+					&(transition->domain_count))) {
+			// Not loaded (e.g. cancelled); stay in the namespace
+			// the domain tree shows.
+			put_ns_name(old_namespace);
+			g_free(old_namespace);
+			return;
+		}
+		g_free(old_namespace);
+		update_tree_data(GTK_TREE_VIEW(transition->treeview),
+							transition->dp);
+	}
 
 	notebook = g_object_get_data(
 				G_OBJECT(transition->window), "notebook");
@@ -689,8 +1648,6 @@ static void set_ns_tab_label(transition_t *transition,
 				GTK_NOTEBOOK(notebook), tab4, namespace);
 	gtk_notebook_set_menu_label_text(
 				GTK_NOTEBOOK(notebook), tab4, namespace);
-
-	put_ns_name(namespace);
 }
 /*---------------------------------------------------------------------------*/
 struct FindIsDis_t {
@@ -722,6 +1679,7 @@ static void cb_initialize_domain(GtkTreeView *treeview, GtkTreePath *treepath,
 	gint			index;
 
 	DEBUG_PRINT("In  **************************** \n");
+	wait_load_job();
 	model = gtk_tree_view_get_model(treeview);
 	if (!gtk_tree_model_get_iter(model, &iter, treepath))
 		return;
@@ -741,7 +1699,7 @@ static void cb_initialize_domain(GtkTreeView *treeview, GtkTreePath *treepath,
 			*cp = '\0';
 		set_ns_tab_label(transition, namespace);
 		g_free(namespace);
-		refresh_transition(NULL, transition);
+		view_cursor_set(GTK_WIDGET(treeview), NULL, NULL);
 		return;
 	} else if (data.redirect_index < 0)
 		return;		/* not initialize_domain */
@@ -1035,9 +1993,11 @@ static void set_select_flag_domain(gpointer data,
 	gtk_tree_model_get(model, &iter, COLUMN_INDEX, &index, -1);
 
 	DEBUG_PRINT("index[%d]\n", index);
+	if (index < 0)	/* a preview row */
+		return;
 	/* deleted_domain or initializer_source */
 	if (!(dp->list[index].is_dd) && !(dp->list[index].target))
-		dp->list_selected[index] = 1;
+		ccs_assign_bit(dp->list_selected, index, true);
 }
 
 gint delete_domain(transition_t *transition,
@@ -1472,7 +2432,7 @@ int gpet_main(char *path)
 	GtkWidget	*menubar, *toolbar = NULL;
 	GtkWidget	*statusbar;
 	gint		contextid;
-	GtkWidget	*vbox;
+	GtkWidget	*vbox, *hbox;
 	GtkWidget	*tab1, *tab2, *tab3, *tab4;
 	GtkWidget	*notebook;
 	GtkWidget	*pane;
@@ -1488,8 +2448,8 @@ int gpet_main(char *path)
 		return 1;
 
 	transition.task_flag = 0;
-	if (get_domain_policy(&dp, &(transition.domain_count)))
-		return 1;
+	/* The domain policy is loaded by the first refresh, with a preview. */
+	transition.domain_count = 0;
 	/*-----------------------------------------------*/
 
 	window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
@@ -1515,9 +2475,13 @@ int gpet_main(char *path)
 	gtk_box_pack_start(GTK_BOX(vbox), notebook, TRUE, TRUE, 0);
 	g_object_set(G_OBJECT(notebook), "can-focus", FALSE, NULL);
 
-	// create status bar
+	// create status bar & load indicator
+	hbox = gtk_hbox_new(FALSE, 1);
+	gtk_box_pack_start(GTK_BOX(vbox), hbox, FALSE, FALSE, 0);
 	statusbar = gtk_statusbar_new();
-	gtk_box_pack_start(GTK_BOX(vbox), statusbar, FALSE, FALSE, 0);
+	gtk_box_pack_start(GTK_BOX(hbox), statusbar, TRUE, TRUE, 0);
+	gtk_box_pack_end(GTK_BOX(hbox), create_load_indicator(),
+							FALSE, FALSE, 0);
 	contextid = gtk_statusbar_get_context_id(GTK_STATUSBAR(statusbar), "");
 	gtk_statusbar_push(GTK_STATUSBAR(statusbar), contextid, _("gpet"));
 
@@ -1580,6 +2544,7 @@ int gpet_main(char *path)
 	transition.statusbar = statusbar;
 	transition.contextid = contextid;
 	transition.dp = &dp;
+	add_tree_data(GTK_TREE_VIEW(treeview), &dp);
 	transition.acl.count = 0;
 	transition.acl.list = NULL;
 	transition.tsk.treeview = create_task_tree_model(&transition);
@@ -1606,6 +2571,8 @@ int gpet_main(char *path)
 	listview = create_list_model(TRUE);
 	create_list_view(tab2, listview, TRUE);
 	transition.exp.listview = listview;
+	transition.exp.count = 0;
+	transition.exp.list = NULL;
 	// mouse click  exception window
 	g_signal_connect(G_OBJECT(listview), "button-press-event",
 			 G_CALLBACK(cb_select_exp), &transition);
@@ -1684,6 +2651,11 @@ int main(int argc, char **argv)
 	textdomain(GETTEXT_PACKAGE);
 #endif
 
+#if !GLIB_CHECK_VERSION(2, 32, 0)
+	// policy is loaded by a worker thread (loader.c)
+	if (!g_thread_supported())
+		g_thread_init(NULL);
+#endif
 	gtk_init(&argc, &argv);
 
 	if (!homedir)
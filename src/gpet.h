@@ -73,6 +73,28 @@ typedef struct _transition_t {
 	enum addentry_type	addentry;
 } transition_t;
 
+typedef struct _load_job_t load_job_t;
+struct _load_job_t {
+	transition_t		*transition;
+	gint	(*load)(load_job_t *job);	// worker thread
+	void	(*done)(load_job_t *job);	// main loop
+	gint			result;
+	gboolean		cancelled;
+	gboolean		hide_view;	// hide "view" while loading
+	gboolean		background;	// pages stay usable meanwhile
+	gboolean		preview;	// show domains as read if empty
+
+	struct ccs_domain_policy3	dp;	// copy of *transition->dp
+	gint			index;
+	struct ccs_generic_acl	*list;
+	gint			count;
+	struct ccs_task_entry	*task;
+
+	GtkWidget		*view;
+	GtkTreePath		*path;		// cursor of "view"
+	GtkTreeViewColumn	*column;
+};
+
 
 //#define DEBUG
 
@@ -97,12 +119,20 @@ int ccs_main(int argc, char *argv[]);
 
 // interface.inc
 int get_domain_policy(struct ccs_domain_policy3 *dp, int *count);
+void release_old_domain_policy(void);
+int get_changed_domains(const int **list);
+void set_domain_read_hook(void (*hook)(const char *domainname));
 int add_domain(char *input, char **err_buff);
 int set_profile(struct ccs_domain_policy3 *dp,
 				char *profile, char **err_buff);
 int get_task_list(struct ccs_task_entry **tsk, int *count);
 const char *get_domain_name(const struct ccs_domain_policy3 *dp,
 				const int index);
+int get_domain_depth(const struct ccs_domain_policy3 *dp, const int index);
+const char *get_domain_last_name(const struct ccs_domain_policy3 *dp,
+				const int index);
+int get_find_target_domain(const struct ccs_domain_policy3 *dp,
+				const int index);
 int get_acl_list(struct ccs_domain_policy3 *dp, int current,
 			struct ccs_generic_acl **ga, int *count);
 int get_process_acl_list(int current,
@@ -131,17 +161,22 @@ int delete_manager_policy(
 		struct ccs_generic_acl *ga, int count, char **err_buff);
 _Bool is_offline(void);
 _Bool is_network(void);
+_Bool is_policy_unchanged(void);
 char *get_remote_ip(char *str_ip);
 const char *get_policy_dir(void);
-const char *get_domain_last_name(const int index);
-int get_find_target_domain(const int index);
 const char *get_ns_name(void);
 void put_ns_name(const char *namespace);
+int select_domain_namespace(struct ccs_domain_policy3 *dp, int *count);
+void get_name_usage(unsigned long *live, unsigned long *reclaimed);
 _Bool is_ccs(void);
 
 // gpet.c
 gchar *decode_from_octal_str(const char *name);
+const gchar *get_display_name(const char *name);
+const gchar *get_display_text(const char *text);
 void add_tree_data(GtkTreeView *treeview, struct ccs_domain_policy3 *dp);
+void update_tree_data(GtkTreeView *treeview, struct ccs_domain_policy3 *dp);
+void add_preview_row(GtkTreeView *treeview, const char *domainname);
 void add_list_data(generic_list_t *generic,
 				enum ccs_screen_type current_page);
 gint get_current_domain_index(transition_t *transition);
@@ -199,4 +234,12 @@ void search_input(GtkAction *action, transition_t *transition);
 void search_back(GtkAction *action, transition_t *transition);
 void search_forward(GtkAction *action, transition_t *transition);
 
+// loader.c
+GtkWidget *create_load_indicator(void);
+load_job_t *new_load_job(transition_t *transition, GtkWidget *view,
+			gint (*load)(load_job_t *), void (*done)(load_job_t *));
+void start_load_job(load_job_t *job);
+void cancel_load_job(void);
+void wait_load_job(void);
+
 #endif /* __GPET_H__ */
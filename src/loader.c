@@ -0,0 +1,363 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Gui Policy Editor for TOMOYO Linux
+ *
+ * loader.c
+ * Copyright (C) Yoshihiro Kusuno 2011 <yocto@users.sourceforge.jp>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <gtk/gtk.h>
+#include <glib/gi18n.h>
+
+#include "gpet.h"
+
+/*
+ * Policy is read by a worker thread so that the window keeps repainting.
+ *
+ * The ccstools side keeps its state in globals (ccs_dp, ccs_gacl_list, ...),
+ * so only one job runs at a time and the main loop must not call into
+ * interface.inc while it runs: the action group and the pages (the notebook
+ * and the detached ACL window) are made insensitive, a view whose data is
+ * being replaced in place is hidden, and the job loads into its own fields.
+ * job->done() is then called from the main loop to swap the result in, which
+ * is the only place views see new data. A "background" job leaves the pages
+ * usable, for it must not replace anything they read.
+ *
+ * A new job of the same kind as the running one cancels it; other jobs wait
+ * in a queue, where a newer job of the same kind replaces an older one.
+ *
+ * A job with "preview" set shows the current namespace's domainnames in an
+ * empty domain view while the domain policy is still being read: the thread
+ * passes each one through a single-producer/single-consumer queue, and a
+ * timeout adds what has arrived to the view's DomainModel once per frame
+ * within PREVIEW_BUDGET.
+ * A view which already shows domains keeps them until job->done(). Names
+ * arrive only while the policy is parsed, not when it has not changed.
+ */
+static load_job_t	*running = NULL;
+static GThread		*load_thread = NULL;
+static guint		finish_id = 0;
+static GQueue		pending = G_QUEUE_INIT;
+
+#define PREVIEW_INTERVAL	16	// ms, about a frame
+#define PREVIEW_BUDGET		0.008	// seconds per frame
+
+/*
+ * Unbounded lock-free queue: the thread links nodes after preview_tail and
+ * the main loop follows "next" from preview_head, a node already consumed.
+ * Nothing is dropped; the queue holds at most the names of one policy.
+ */
+typedef struct _preview_node_t preview_node_t;
+struct _preview_node_t {
+	preview_node_t	*next;
+	gchar		*domainname;
+};
+static preview_node_t	preview_stub;
+static preview_node_t	*preview_head = &preview_stub;
+static preview_node_t	*preview_tail = &preview_stub;
+static GtkTreeModel	*preview_model = NULL;
+static guint		preview_id = 0;
+
+static GtkWidget	*indicator = NULL;
+static GtkWidget	*progress = NULL;
+static guint		pulse_id = 0;
+/*---------------------------------------------------------------------------*/
+static void free_generic_acl(struct ccs_generic_acl *list, gint count)
+{
+	while (count)
+		free((void *)list[--count].operand);
+	free(list);
+}
+
+static void free_load_job(load_job_t *job)
+{
+	if (job->path)
+		gtk_tree_path_free(job->path);
+	free_generic_acl(job->list, job->count);
+	g_free(job);
+}
+
+load_job_t *new_load_job(transition_t *transition, GtkWidget *view,
+			gint (*load)(load_job_t *), void (*done)(load_job_t *))
+{
+	load_job_t	*job = g_new0(load_job_t, 1);
+
+	job->transition = transition;
+	job->load = load;
+	job->done = done;
+	job->view = view;
+	if (view)
+		gtk_tree_view_get_cursor(GTK_TREE_VIEW(view),
+					&(job->path), &(job->column));
+	return job;
+}
+/*---------------------------------------------------------------------------*/
+// worker thread
+static void preview_push(const char *domainname)
+{
+	preview_node_t	*node = g_new(preview_node_t, 1);
+
+	node->next = NULL;
+	node->domainname = g_strdup(domainname);
+	g_atomic_pointer_set(&preview_tail->next, node);
+	preview_tail = node;
+}
+
+// main loop; the caller frees the returned name
+static gchar *preview_pop(void)
+{
+	preview_node_t	*node = g_atomic_pointer_get(&preview_head->next);
+
+	if (!node)
+		return NULL;
+	if (preview_head != &preview_stub)
+		g_free(preview_head);
+	preview_head = node;
+	return node->domainname;
+}
+
+static gboolean preview_drain(gpointer data)
+{
+	GTimer	*timer = g_timer_new();
+	gchar	*domainname;
+
+	while (g_timer_elapsed(timer, NULL) < PREVIEW_BUDGET &&
+	       (domainname = preview_pop())) {
+		add_preview_row(GTK_TREE_VIEW(data), domainname);
+		g_free(domainname);
+	}
+	g_timer_destroy(timer);
+	return TRUE;
+}
+
+static void start_preview(load_job_t *job)
+{
+	GtkTreeModel	*model;
+
+	model = gtk_tree_view_get_model(GTK_TREE_VIEW(job->view));
+	if (!model || gtk_tree_model_iter_n_children(model, NULL))
+		return;
+	preview_model = g_object_ref(model);
+	set_domain_read_hook(preview_push);
+	preview_id = g_timeout_add(PREVIEW_INTERVAL,
+					preview_drain, job->view);
+}
+
+// after the thread has been joined
+static void stop_preview(load_job_t *job)
+{
+	gchar	*domainname;
+
+	if (!preview_model)
+		return;
+	set_domain_read_hook(NULL);
+	g_source_remove(preview_id);
+	preview_id = 0;
+	while ((domainname = preview_pop()))
+		g_free(domainname);
+	if (preview_head != &preview_stub)
+		g_free(preview_head);
+	preview_stub.next = NULL;
+	preview_head = preview_tail = &preview_stub;
+	g_object_unref(preview_model);
+	preview_model = NULL;
+}
+/*---------------------------------------------------------------------------*/
+static void set_pages_sensitive(transition_t *transition, gboolean sensitive)
+{
+	GtkWidget	*notebook;
+
+	notebook = g_object_get_data(
+				G_OBJECT(transition->window), "notebook");
+	gtk_widget_set_sensitive(notebook, sensitive);
+	gtk_widget_set_sensitive(transition->acl_window, sensitive);
+}
+
+static gboolean pulse_progress(gpointer data)
+{
+	gchar	*text;
+
+	text = g_strdup_printf(_("Loading... %lu KiB"),
+					ccs_read_total / 1024);
+	gtk_progress_bar_set_text(GTK_PROGRESS_BAR(progress), text);
+	gtk_progress_bar_pulse(GTK_PROGRESS_BAR(progress));
+	g_free(text);
+	return TRUE;
+}
+
+static gboolean cb_finish_job(gpointer data);
+
+static gpointer load_thread_func(gpointer data)
+{
+	load_job_t	*job = data;
+
+	job->result = job->load(job);
+	/* A thread is started per job, so its buffers would leak. */
+	ccs_release_thread_buffers();
+	finish_id = g_idle_add(cb_finish_job, job);
+	return NULL;
+}
+
+static void launch_job(load_job_t *job)
+{
+	transition_t	*transition = job->transition;
+
+	running = job;
+	/* Take the copy now; a job which was queued may see newer data. */
+	job->dp = *(transition->dp);
+	if (!job->background)
+		set_pages_sensitive(transition, FALSE);
+	if (job->hide_view && job->view)
+		gtk_widget_hide(job->view);
+	if (job->preview && job->view)
+		start_preview(job);
+
+	if (!pulse_id) {
+		gtk_action_group_set_sensitive(transition->actions, FALSE);
+		gtk_progress_bar_set_text(GTK_PROGRESS_BAR(progress),
+							_("Loading..."));
+		gtk_widget_show(indicator);
+		pulse_id = g_timeout_add(100, pulse_progress, NULL);
+	}
+
+	ccs_read_cancelled = false;
+	ccs_read_total = 0;
+#if GLIB_CHECK_VERSION(2, 32, 0)
+	load_thread = g_thread_new("loader", load_thread_func, job);
+#else
+	load_thread = g_thread_create(load_thread_func, job, TRUE, NULL);
+#endif
+}
+
+static void finish_job(load_job_t *job, gboolean from_idle)
+{
+	transition_t	*transition = job->transition;
+
+	/* finish_id is stored by the thread, so read it after joining. */
+	g_thread_join(load_thread);
+	load_thread = NULL;
+	if (!from_idle)
+		g_source_remove(finish_id);
+	finish_id = 0;
+	running = NULL;
+	ccs_read_cancelled = false;
+
+	if (job->hide_view && job->view)
+		gtk_widget_show(job->view);
+	if (job->preview && job->view)
+		stop_preview(job);
+	/* before job->done(), which may grab the focus */
+	if (!job->background)
+		set_pages_sensitive(transition, TRUE);
+	job->done(job);
+	if (job->cancelled && g_queue_is_empty(&pending))
+		gtk_statusbar_push(GTK_STATUSBAR(transition->statusbar),
+			transition->contextid, _("Loading cancelled."));
+	free_load_job(job);
+	if (running)	/* job->done() started another job. */
+		return;
+
+	job = g_queue_pop_head(&pending);
+	if (job) {
+		launch_job(job);
+		return;
+	}
+	g_source_remove(pulse_id);
+	pulse_id = 0;
+	gtk_widget_hide(indicator);
+	gtk_action_group_set_sensitive(transition->actions, TRUE);
+}
+
+static gboolean cb_finish_job(gpointer data)
+{
+	finish_job(data, TRUE);
+	return FALSE;
+}
+/*---------------------------------------------------------------------------*/
+void start_load_job(load_job_t *job)
+{
+	GList	*list;
+
+	if (running && running->load == job->load) {
+		running->cancelled = TRUE;
+		ccs_read_cancelled = true;
+	}
+	for (list = pending.head; list; list = g_list_next(list)) {
+		load_job_t	*old = list->data;
+
+		if (old->load == job->load) {
+			g_queue_delete_link(&pending, list);
+			free_load_job(old);
+			break;
+		}
+	}
+
+	if (running)
+		g_queue_push_tail(&pending, job);
+	else
+		launch_job(job);
+}
+
+void cancel_load_job(void)
+{
+	load_job_t	*job;
+
+	while ((job = g_queue_pop_head(&pending)))
+		free_load_job(job);
+	if (running) {
+		running->cancelled = TRUE;
+		ccs_read_cancelled = true;
+	}
+}
+
+/* Completes all jobs before the caller uses interface.inc directly. */
+void wait_load_job(void)
+{
+	while (running)
+		finish_job(running, FALSE);
+}
+/*---------------------------------------------------------------------------*/
+static void cb_cancel(GtkButton *button, gpointer data)
+{
+	cancel_load_job();
+}
+
+GtkWidget *create_load_indicator(void)
+{
+	GtkWidget	*button;
+
+	indicator = gtk_hbox_new(FALSE, 1);
+	gtk_widget_set_no_show_all(indicator, TRUE);
+
+	progress = gtk_progress_bar_new();
+	gtk_progress_bar_set_pulse_step(GTK_PROGRESS_BAR(progress), 0.1);
+	gtk_box_pack_start(GTK_BOX(indicator), progress, FALSE, FALSE, 0);
+	gtk_widget_show(progress);
+
+	button = gtk_button_new_from_stock(GTK_STOCK_CANCEL);
+	gtk_button_set_relief(GTK_BUTTON(button), GTK_RELIEF_NONE);
+	g_signal_connect(G_OBJECT(button), "clicked",
+				G_CALLBACK(cb_cancel), NULL);
+	gtk_box_pack_start(GTK_BOX(indicator), button, FALSE, FALSE, 0);
+	gtk_widget_show(button);
+
+	return indicator;
+}
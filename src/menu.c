@@ -222,6 +222,7 @@ GtkWidget *create_menu(GtkWidget *parent, transition_t *transition,
 void disp_statusbar(transition_t *transition, int scr)
 {
 	gchar	*status_str = NULL;
+	unsigned long	live, reclaimed;
 
 	switch (scr) {
 	case CCS_SCREEN_EXCEPTION_LIST :
@@ -246,8 +247,11 @@ void disp_statusbar(transition_t *transition, int scr)
 				transition->domain_count, transition->acl.count);
 		break;
 	case CCS_MAXSCREEN :
-		status_str = g_strdup_printf("Domain[%d]",
-			transition->domain_count);
+		get_name_usage(&live, &reclaimed);
+		status_str = g_strdup_printf(
+			"Domain[%d] Name[%luKB Reclaimed %luKB]",
+			transition->domain_count,
+			live / 1024, reclaimed / 1024);
 		break;
 	default :
 		g_warning("BUG: screen [%d]  file(%s) line(%d)",
@@ -530,82 +534,146 @@ static void clear_acl_view(transition_t *transition)
 	add_list_data(&(transition->acl), CCS_SCREEN_ACL_LIST);
 }
 
+/*
+ * Loading runs in loader.c's worker thread: load_*() read policy into the
+ * job, show_*() put it into transition and the views from the main loop.
+ */
+static gint load_exception(load_job_t *job)
+{
+	return get_exception_policy(&(job->list), &(job->count));
+}
+
+static gint load_profile(load_job_t *job)
+{
+	return get_profile(&(job->list), &(job->count));
+}
+
+static gint load_namespace(load_job_t *job)
+{
+	return get_namespace(&(job->list), &(job->count));
+}
+
+static void show_generic(load_job_t *job, generic_list_t *generic,
+				enum ccs_screen_type type)
+{
+	transition_t		*transition = job->transition;
+	struct ccs_generic_acl	*list = generic->list;
+	int			count = generic->count;
+
+	if (job->result || job->cancelled)
+		return;
+	// swap; the old list is freed with the job
+	generic->list = job->list;
+	generic->count = job->count;
+	job->list = list;
+	job->count = count;
+	if (!is_policy_unchanged())
+		add_list_data(generic, type);
+	set_position_addentry(transition, &(job->path));
+	disp_statusbar(transition, type);
+	view_cursor_set(job->view, job->path, job->column);
+	job->path = NULL;
+	gtk_widget_grab_focus(job->view);
+}
+
+static void show_exception(load_job_t *job)
+{
+	show_generic(job, &(job->transition->exp), CCS_SCREEN_EXCEPTION_LIST);
+}
+
+static void show_profile(load_job_t *job)
+{
+	show_generic(job, &(job->transition->prf), CCS_SCREEN_PROFILE_LIST);
+}
+
+static void show_namespace(load_job_t *job)
+{
+	show_generic(job, &(job->transition->ns), CCS_SCREEN_NS_LIST);
+}
+
+static gint load_task(load_job_t *job)
+{
+	return get_task_list(&(job->task), &(job->count));
+}
+
+static void show_task(load_job_t *job)
+{
+	transition_t	*transition = job->transition;
+
+	// job->task is ccs_task_list itself, which the load may have moved.
+	transition->tsk.task = job->task;
+	transition->tsk.count = job->count;
+	job->count = 0;
+	if (job->result)
+		return;
+	add_task_tree_data(GTK_TREE_VIEW(job->view), &(transition->tsk));
+	gtk_tree_view_expand_all(GTK_TREE_VIEW(job->view));
+	if (job->cancelled)
+		return;
+	view_cursor_set(job->view, job->path, job->column);
+	job->path = NULL;
+	gtk_widget_grab_focus(job->view);
+}
+
+static gint load_domain(load_job_t *job)
+{
+	return get_domain_policy(&(job->dp), &(job->count));
+}
+
+static void show_domain(load_job_t *job)
+{
+	transition_t	*transition = job->transition;
+
+	// job->dp is still the old policy if the load was cancelled.
+	*(transition->dp) = job->dp;
+	transition->domain_count = job->count;
+	update_tree_data(GTK_TREE_VIEW(job->view), transition->dp);
+	release_old_domain_policy();
+	if (job->result || job->cancelled)
+		return;
+	set_position_addentry(transition, &(job->path));
+	if (transition->domain_count) {
+		view_cursor_set(job->view, job->path, job->column);
+		job->path = NULL;
+	} else
+		clear_acl_view(transition);
+	gtk_widget_grab_focus(job->view);
+}
+
 void refresh_transition(GtkAction *action, transition_t *transition)
 {
 	GtkTreePath		*path = NULL;
 	GtkTreeViewColumn	*column = NULL;
 	GtkWidget		*view = NULL;
+	load_job_t		*job = NULL;
 
 	DEBUG_PRINT("In  Refresh Page[%d]\n", (int)transition->current_page);
 	switch((int)transition->current_page) {
 	case CCS_SCREEN_EXCEPTION_LIST :
-		view = transition->exp.listview;
-		gtk_tree_view_get_cursor(GTK_TREE_VIEW(view),
-							&path, &column);
-		if (get_exception_policy(
-		    &(transition->exp.list), &(transition->exp.count)))
-			break;
-		add_list_data(&(transition->exp), CCS_SCREEN_EXCEPTION_LIST);
-		set_position_addentry(transition, &path);
-		disp_statusbar(transition, CCS_SCREEN_EXCEPTION_LIST);
-		view_cursor_set(view, path, column);
-		gtk_widget_grab_focus(view);
+		job = new_load_job(transition, transition->exp.listview,
+					load_exception, show_exception);
 		break;
 	case CCS_SCREEN_PROFILE_LIST :
-		view = transition->prf.listview;
-		gtk_tree_view_get_cursor(GTK_TREE_VIEW(view),
-							&path, &column);
-		if (get_profile(
-		    &(transition->prf.list), &(transition->prf.count)))
-			break;
-		add_list_data(&(transition->prf), CCS_SCREEN_PROFILE_LIST);
-		set_position_addentry(transition, &path);
-		disp_statusbar(transition, CCS_SCREEN_PROFILE_LIST);
-		view_cursor_set(view, path, column);
-		gtk_widget_grab_focus(view);
+		job = new_load_job(transition, transition->prf.listview,
+					load_profile, show_profile);
 		break;
 	case CCS_SCREEN_NS_LIST :
-		view = transition->ns.listview;
-		gtk_tree_view_get_cursor(GTK_TREE_VIEW(view),
-							&path, &column);
-		if (get_namespace(
-		    &(transition->ns.list), &(transition->ns.count)))
-			break;
-		add_list_data(&(transition->ns), CCS_SCREEN_NS_LIST);
-		set_position_addentry(transition, &path);
-		disp_statusbar(transition, CCS_SCREEN_NS_LIST);
-		view_cursor_set(view, path, column);
-		gtk_widget_grab_focus(view);
+		job = new_load_job(transition, transition->ns.listview,
+					load_namespace, show_namespace);
 		break;
 	case CCS_SCREEN_DOMAIN_LIST :
 	case CCS_MAXSCREEN :
-		view = transition->task_flag ?
-			transition->tsk.treeview : transition->treeview;
-		gtk_tree_view_get_cursor(
-				GTK_TREE_VIEW(view), &path, &column);
-
-		gtk_widget_hide(view);
-		if (transition->task_flag) {
-			if (get_task_list(&(transition->tsk.task),
-						&(transition->tsk.count)))
-				break;
-			add_task_tree_data(GTK_TREE_VIEW(view), &(transition->tsk));
-			gtk_tree_view_expand_all(GTK_TREE_VIEW(view));
-			view_cursor_set(view, path, column);
-		} else {
-			if (get_domain_policy(
-			    transition->dp, &(transition->domain_count)))
-				break;
-			add_tree_data(GTK_TREE_VIEW(view), transition->dp);
-			gtk_tree_view_expand_all(GTK_TREE_VIEW(view));
-			set_position_addentry(transition, &path);
-			if (transition->domain_count)
-				view_cursor_set(view, path, column);
-			else
-				clear_acl_view(transition);
-		}
-		gtk_widget_show(view);
-		gtk_widget_grab_focus(view);
+		if (transition->task_flag)
+			job = new_load_job(transition,
+					transition->tsk.treeview,
+					load_task, show_task);
+		else
+			job = new_load_job(transition, transition->treeview,
+					load_domain, show_domain);
+		if (transition->task_flag)
+			job->hide_view = TRUE;
+		else
+			job->preview = TRUE;
 		break;
 	case CCS_SCREEN_ACL_LIST :
 		view = transition->task_flag ?
@@ -616,6 +684,8 @@ void refresh_transition(GtkAction *action, transition_t *transition)
 		gtk_widget_grab_focus(transition->acl.listview);
 		break;
 	}
+	if (job)
+		start_load_job(job);
 
 	if (transition->acl_detached) {
 		DEBUG_PRINT("★Transition[%d] Acl[%d]\n",
@@ -635,8 +705,8 @@ static void copy_line(GtkAction *action, transition_t *transition)
 		index = get_current_domain_index(transition);
 		view = transition->treeview;
 		if (index >= 0)
-			insert_history_buffer(view, decode_from_octal_str(
-				get_domain_name(transition->dp, index)));
+			insert_history_buffer(view, g_strdup(get_display_name(
+				get_domain_name(transition->dp, index))));
 		break;
 	case CCS_SCREEN_ACL_LIST :
 		view = transition->acl.listview;
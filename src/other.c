@@ -171,6 +171,7 @@ static void add_list_manager(generic_list_t *man)
 	gtk_tree_view_get_cursor(GTK_TREE_VIEW(
 			man->listview), &path, &column);
 
+	wait_load_job();
 	get_manager(&(man->list), &(man->count));
 	store = GTK_LIST_STORE(gtk_tree_view_get_model(
 					GTK_TREE_VIEW(man->listview)));
@@ -578,6 +579,7 @@ gboolean check_manager_policy(char *real_path)
 
 	manager.count = 0;
 	manager.list = NULL;
+	wait_load_job();
 	get_manager(&(manager.list), &(manager.count));
 	DEBUG_PRINT("manager.count[%d]\n", manager.count);
 	// search own
@@ -691,6 +693,7 @@ static void add_list_memory(generic_list_t *mem)
 	gint			i;
 	gchar			*head, *now, *quota;
 
+	wait_load_job();
 	get_memory(&(mem->list), &(mem->count));
 	store = GTK_LIST_STORE(gtk_tree_view_get_model(
 					GTK_TREE_VIEW(mem->listview)));
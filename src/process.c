@@ -45,7 +45,6 @@ static int add_task_tree_store(GtkTreeStore *store,
 {
 	GtkTreeIter	iter;
 	gchar		*str_prof;
-	gchar		*str_domain;
 	gchar		*line;
 	int		n = 0, index;
 
@@ -53,11 +52,10 @@ static int add_task_tree_store(GtkTreeStore *store,
 
 	index = tsk->task[*number].index;
 	str_prof = g_strdup_printf("%3u", tsk->task[*number].profile);
-	str_domain = decode_from_octal_str(tsk->task[*number].domain);
 	line = g_strdup_printf("%s (%u) %s",
 				tsk->task[*number].name,
 				tsk->task[*number].pid,
-				str_domain);
+				get_display_text(tsk->task[*number].domain));
 	gtk_tree_store_set(store, &iter,
 				COLUMN_INDEX,		index,
 				COLUMN_NUMBER,  	*number,
@@ -66,7 +64,6 @@ static int add_task_tree_store(GtkTreeStore *store,
 				COLUMN_NAME,		line,
 				-1);
 	DEBUG_PRINT("[%3d]%3d(%d):%s %s\n", index, *number, nest, str_prof, line);
-	g_free(str_domain);
 	g_free(str_prof);
 	g_free(line);
 
@@ -156,7 +153,6 @@ static void cb_selection_proc(GtkTreeSelection *selection,
 	GtkTreeModel		*model;
 	GList			*list;
 	gint			index;
-	gchar			*str_domain;
 	GtkTreePath		*path = NULL;
 	GtkTreeViewColumn	*column = NULL;
 
@@ -172,9 +168,9 @@ static void cb_selection_proc(GtkTreeSelection *selection,
 	g_list_free(list);
 	gtk_tree_model_get(model, &iter, COLUMN_INDEX, &index, -1);
 
-	str_domain = decode_from_octal_str(transition->tsk.task[index].domain);
-	gtk_entry_set_text(GTK_ENTRY(transition->domainbar), str_domain);
-	g_free(str_domain);
+	wait_load_job();
+	gtk_entry_set_text(GTK_ENTRY(transition->domainbar),
+			get_display_text(transition->tsk.task[index].domain));
 
 	gtk_tree_view_get_cursor(GTK_TREE_VIEW(
 			transition->acl.listview), &path, &column);
@@ -264,7 +264,8 @@ static void search(transition_t *transition, gboolean forward)
 				str_p = transition->tsk.task[index].name;
 			} else {
 				view = transition->treeview;
-				str_p = (gchar *)get_domain_last_name(index);
+				str_p = (gchar *)get_domain_last_name(
+						transition->dp, index);
 			}
 			break;
 		case CCS_SCREEN_ACL_LIST :
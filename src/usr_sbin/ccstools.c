@@ -22,12 +22,40 @@
  */
 #include "ccstools.h"
 
+struct ccs_savename_arena {
+	struct ccs_savename_arena *next;
+	size_t size;        /* Bytes allocated for buf. */
+	size_t used;        /* Bytes used in buf. */
+	size_t count;       /* Number of live entries in buf. */
+	char buf[];
+};
+
 struct ccs_savename_entry {
-	struct ccs_savename_entry *next;
 	struct ccs_path_info entry;
+	struct ccs_savename_arena *arena;
+	unsigned int generation; /* Generation which used this entry last. */
+	unsigned int size;       /* Bytes used in arena. */
 };
 
-#define CCS_SAVENAME_MAX_HASH            256
+/* Initial number of slots in the table used by ccs_savename(). */
+#define CCS_SAVENAME_MIN_HASH            1024
+/* Minimal size of an arena used by ccs_savename(). */
+#define CCS_SAVENAME_ARENA_SIZE          65536
+
+/* The table of names. NULL if unused slot. */
+static struct ccs_savename_entry **ccs_name_list = NULL;
+/* Number of slots in ccs_name_list. Always a power of 2. */
+static unsigned int ccs_name_list_size = 0;
+/* Number of used slots in ccs_name_list. */
+static unsigned int ccs_name_list_len = 0;
+/* Arenas holding names, the newest first. */
+static struct ccs_savename_arena *ccs_name_arena = NULL;
+/* Current generation of names. */
+static unsigned int ccs_name_generation = 0;
+/* Bytes used by names in ccs_name_list. */
+static unsigned long ccs_name_live_bytes = 0;
+/* Bytes used by names reclaimed by ccs_savename_reclaim() so far. */
+static unsigned long ccs_name_reclaimed_bytes = 0;
 
 /* Use ccs-editpolicy-agent process? */
 _Bool ccs_network_mode = false;
@@ -39,8 +67,12 @@ u16 ccs_network_port = 0;
 struct ccs_task_entry *ccs_task_list = NULL;
 /* The length of ccs_task_list . */
 int ccs_task_list_len = 0;
-/* Read files without calling ccs_normalize_line() ? */
-_Bool ccs_freadline_raw = false;
+/* Number of elements allocated for ccs_task_list . */
+static int ccs_task_list_capacity = 0;
+/* Make ccs_reader_readline() stop reading as if end of stream was reached? */
+volatile _Bool ccs_read_cancelled = false;
+/* Bytes read by ccs_reader_readline() since last reset by the caller. */
+volatile unsigned long ccs_read_total = 0;
 
 /* Prototypes */
 
@@ -133,6 +165,159 @@ void *ccs_malloc(const size_t size)
 	return vp;
 }
 
+/**
+ * ccs_grow - Make room for appending an element to an array.
+ *
+ * @ptr:      Pointer to the array. Maybe NULL.
+ * @capacity: Pointer to number of elements allocated for @ptr.
+ * @len:      Number of elements in use.
+ * @size:     Size of an element.
+ *
+ * Returns @ptr or reallocated pointer which has room for at least @len + 1
+ * elements on success, abort otherwise.
+ *
+ * The capacity is doubled whenever it runs out, so that appending n elements
+ * one by one costs O(n) in total.
+ */
+void *ccs_grow(void *ptr, int *capacity, const int len, const size_t size)
+{
+	if (len < *capacity)
+		return ptr;
+	*capacity = len ? len * 2 : 4;
+	return ccs_realloc(ptr, *capacity * size);
+}
+
+/**
+ * ccs_bitmap_resize - Resize a bitmap and clear all bits.
+ *
+ * @map: Pointer to "unsigned long". Maybe NULL.
+ * @len: Number of bits.
+ *
+ * Returns @map or reallocated pointer on success, abort otherwise.
+ */
+unsigned long *ccs_bitmap_resize(unsigned long *map, const int len)
+{
+	const size_t size = CCS_BITMAP_LONGS(len ? len : 1) *
+		sizeof(unsigned long);
+	return ccs_realloc2(map, size);
+}
+
+/**
+ * ccs_test_bit - Check whether a bit in a bitmap is set.
+ *
+ * @map:   Pointer to "const unsigned long".
+ * @index: Index of the bit.
+ *
+ * Returns true if set, false otherwise.
+ */
+_Bool ccs_test_bit(const unsigned long *map, const int index)
+{
+	return (map[index / CCS_BITS_PER_LONG] >>
+		(index % CCS_BITS_PER_LONG)) & 1;
+}
+
+/**
+ * ccs_assign_bit - Set or clear a bit in a bitmap.
+ *
+ * @map:   Pointer to "unsigned long".
+ * @index: Index of the bit.
+ * @value: True to set, false to clear.
+ *
+ * Returns nothing.
+ */
+void ccs_assign_bit(unsigned long *map, const int index, const _Bool value)
+{
+	const unsigned long mask = 1UL << (index % CCS_BITS_PER_LONG);
+	if (value)
+		map[index / CCS_BITS_PER_LONG] |= mask;
+	else
+		map[index / CCS_BITS_PER_LONG] &= ~mask;
+}
+
+/**
+ * ccs_change_bit - Toggle a bit in a bitmap.
+ *
+ * @map:   Pointer to "unsigned long".
+ * @index: Index of the bit.
+ *
+ * Returns nothing.
+ */
+void ccs_change_bit(unsigned long *map, const int index)
+{
+	map[index / CCS_BITS_PER_LONG] ^= 1UL << (index % CCS_BITS_PER_LONG);
+}
+
+/**
+ * ccs_assign_bits - Set or clear a range of bits in a bitmap.
+ *
+ * @map:   Pointer to "unsigned long".
+ * @start: Index of the first bit.
+ * @end:   Index of the bit after the last one.
+ * @value: True to set, false to clear.
+ *
+ * Returns nothing.
+ *
+ * Whole words are filled at once.
+ */
+void ccs_assign_bits(unsigned long *map, int start, const int end,
+		     const _Bool value)
+{
+	while (start < end && start % CCS_BITS_PER_LONG)
+		ccs_assign_bit(map, start++, value);
+	while (end - start >= CCS_BITS_PER_LONG) {
+		map[start / CCS_BITS_PER_LONG] = value ? ~0UL : 0;
+		start += CCS_BITS_PER_LONG;
+	}
+	while (start < end)
+		ccs_assign_bit(map, start++, value);
+}
+
+/**
+ * ccs_bitmap_weight - Count set bits in a bitmap.
+ *
+ * @map: Pointer to "const unsigned long".
+ * @len: Number of bits.
+ *
+ * Returns number of set bits.
+ */
+int ccs_bitmap_weight(const unsigned long *map, const int len)
+{
+	const int words = len / CCS_BITS_PER_LONG;
+	const int rest = len % CCS_BITS_PER_LONG;
+	int count = 0;
+	int i;
+	for (i = 0; i < words; i++)
+		count += __builtin_popcountl(map[i]);
+	if (rest)
+		count += __builtin_popcountl(map[i] & ((1UL << rest) - 1));
+	return count;
+}
+
+/**
+ * ccs_find_next_bit - Find next set bit in a bitmap.
+ *
+ * @map:   Pointer to "const unsigned long".
+ * @len:   Number of bits.
+ * @index: Index of the bit to start with.
+ *
+ * Returns index of the first set bit at or after @index, @len if none.
+ *
+ * Words without set bits are skipped at once.
+ */
+int ccs_find_next_bit(const unsigned long *map, const int len, int index)
+{
+	while (index < len) {
+		const unsigned long word = map[index / CCS_BITS_PER_LONG] >>
+			(index % CCS_BITS_PER_LONG);
+		if (word) {
+			index += __builtin_ctzl(word);
+			break;
+		}
+		index = (index / CCS_BITS_PER_LONG + 1) * CCS_BITS_PER_LONG;
+	}
+	return index < len ? index : len;
+}
+
 /**
  * ccs_str_starts - Check whether the given string starts with the given keyword.
  *
@@ -252,19 +437,18 @@ void ccs_normalize_line(char *buffer)
 }
 
 /**
- * ccs_partial_name_hash - Hash name.
+ * ccs_mix_name_hash - Mix a word into hash value.
  *
- * @c:        A unsigned long value.
+ * @word:     A word read from a name.
  * @prevhash: A previous hash value.
  *
  * Returns new hash value.
- *
- * This function is copied from partial_name_hash() in the kernel source.
  */
-static inline unsigned long ccs_partial_name_hash(unsigned long c,
-						  unsigned long prevhash)
+static inline unsigned long long ccs_mix_name_hash(unsigned long long word,
+						   unsigned long long prevhash)
 {
-	return (prevhash + (c << 4) + (c >> 4)) * 11;
+	prevhash = (prevhash ^ word) * 0xff51afd7ed558ccdULL;
+	return prevhash ^ (prevhash >> 32);
 }
 
 /**
@@ -275,15 +459,27 @@ static inline unsigned long ccs_partial_name_hash(unsigned long c,
  *
  * Returns hash value.
  *
- * This function is copied from full_name_hash() in the kernel source.
+ * The name is consumed eight bytes at a time. The value depends on the byte
+ * order of the host, which is fine because hash values are never stored.
  */
 static inline unsigned int ccs_full_name_hash(const unsigned char *name,
 					      unsigned int len)
 {
-	unsigned long hash = 0;
-	while (len--)
-		hash = ccs_partial_name_hash(*name++, hash);
-	return (unsigned int) hash;
+	unsigned long long hash = len * 0x9e3779b97f4a7c15ULL;
+	unsigned long long word;
+	while (len >= sizeof(word)) {
+		memcpy(&word, name, sizeof(word));
+		hash = ccs_mix_name_hash(word, hash);
+		name += sizeof(word);
+		len -= sizeof(word);
+	}
+	if (len) {
+		word = 0;
+		memcpy(&word, name, len);
+		hash = ccs_mix_name_hash(word, hash);
+	}
+	hash *= 0xc4ceb9fe1a85ec53ULL;
+	return (unsigned int) (hash ^ (hash >> 29));
 }
 
 /**
@@ -871,6 +1067,75 @@ void ccs_fill_path_info(struct ccs_path_info *ptr)
 	ptr->hash = ccs_full_name_hash((const unsigned char *) name, len);
 }
 
+/**
+ * ccs_savename_insert - Insert an entry into ccs_name_list.
+ *
+ * @ptr: Pointer to "struct ccs_savename_entry".
+ *
+ * Returns nothing.
+ *
+ * The caller must make sure that ccs_name_list has an unused slot and does not
+ * hold the same name.
+ */
+static void ccs_savename_insert(struct ccs_savename_entry *ptr)
+{
+	const unsigned int mask = ccs_name_list_size - 1;
+	unsigned int i = ptr->entry.hash & mask;
+	while (ccs_name_list[i])
+		i = (i + 1) & mask;
+	ccs_name_list[i] = ptr;
+}
+
+/**
+ * ccs_savename_rehash - Rebuild ccs_name_list.
+ *
+ * @size: Number of slots. Must be a power of 2.
+ *
+ * Returns nothing.
+ */
+static void ccs_savename_rehash(const unsigned int size)
+{
+	struct ccs_savename_entry **old = ccs_name_list;
+	const unsigned int old_size = ccs_name_list_size;
+	unsigned int i;
+	ccs_name_list = ccs_malloc(size * sizeof(*ccs_name_list));
+	ccs_name_list_size = size;
+	for (i = 0; i < old_size; i++)
+		if (old[i])
+			ccs_savename_insert(old[i]);
+	free(old);
+}
+
+/**
+ * ccs_savename_alloc - Allocate memory for an entry.
+ *
+ * @size: Size in bytes.
+ *
+ * Returns pointer to "struct ccs_savename_entry" on success, abort otherwise.
+ *
+ * Entries are carved from the newest arena, which holds only entries created
+ * in the current generation.
+ */
+static struct ccs_savename_entry *ccs_savename_alloc(const size_t size)
+{
+	struct ccs_savename_arena *arena = ccs_name_arena;
+	struct ccs_savename_entry *ptr;
+	if (!arena || arena->size - arena->used < size) {
+		const size_t len = size > CCS_SAVENAME_ARENA_SIZE ?
+			size : CCS_SAVENAME_ARENA_SIZE;
+		arena = ccs_malloc(sizeof(*arena) + len);
+		arena->size = len;
+		arena->next = ccs_name_arena;
+		ccs_name_arena = arena;
+	}
+	ptr = (struct ccs_savename_entry *) (arena->buf + arena->used);
+	arena->used += size;
+	arena->count++;
+	ptr->arena = arena;
+	ptr->size = size;
+	return ptr;
+}
+
 /**
  * ccs_savename - Remember string data.
  *
@@ -879,44 +1144,117 @@ void ccs_fill_path_info(struct ccs_path_info *ptr)
  * Returns pointer to "const struct ccs_path_info" on success, abort otherwise.
  *
  * The returned pointer refers shared string. Thus, the caller must not free().
+ * The string remains valid until ccs_savename_reclaim() is called in a later
+ * generation without this function having been called for the same string in
+ * that generation.
  */
 const struct ccs_path_info *ccs_savename(const char *name)
 {
-	/* The list of names. */
-	static struct ccs_savename_entry name_list[CCS_SAVENAME_MAX_HASH];
+	const unsigned int mask = ccs_name_list_size - 1;
 	struct ccs_savename_entry *ptr;
-	struct ccs_savename_entry *prev = NULL;
 	unsigned int hash;
 	int len;
-	static _Bool first_call = true;
 	if (!name)
 		ccs_out_of_memory();
 	len = strlen(name) + 1;
 	hash = ccs_full_name_hash((const unsigned char *) name, len - 1);
-	if (first_call) {
-		int i;
-		first_call = false;
-		memset(&name_list, 0, sizeof(name_list));
-		for (i = 0; i < CCS_SAVENAME_MAX_HASH; i++) {
-			name_list[i].entry.name = "/";
-			ccs_fill_path_info(&name_list[i].entry);
-		}
-	}
-	for (ptr = &name_list[hash % CCS_SAVENAME_MAX_HASH]; ptr;
-	     ptr = ptr->next) {
-		if (hash == ptr->entry.hash && !strcmp(name, ptr->entry.name))
+	if (ccs_name_list_size) {
+		unsigned int i;
+		for (i = hash & mask; ccs_name_list[i]; i = (i + 1) & mask) {
+			ptr = ccs_name_list[i];
+			if (hash != ptr->entry.hash ||
+			    strcmp(name, ptr->entry.name))
+				continue;
+			ptr->generation = ccs_name_generation;
 			return &ptr->entry;
-		prev = ptr;
+		}
 	}
-	ptr = ccs_malloc(sizeof(*ptr) + len);
-	ptr->next = NULL;
+	/* Keep the table at most half full. */
+	if ((ccs_name_list_len + 1) * 2 > ccs_name_list_size)
+		ccs_savename_rehash(ccs_name_list_size ?
+				    ccs_name_list_size * 2 :
+				    CCS_SAVENAME_MIN_HASH);
+	/* Keep entries aligned. */
+	ptr = ccs_savename_alloc((sizeof(*ptr) + len + sizeof(void *) - 1) &
+				 ~(sizeof(void *) - 1));
 	ptr->entry.name = ((char *) ptr) + sizeof(*ptr);
 	memmove((void *) ptr->entry.name, name, len);
 	ccs_fill_path_info(&ptr->entry);
-	prev->next = ptr; /* prev != NULL because name_list is not empty. */
+	ptr->generation = ccs_name_generation;
+	ccs_savename_insert(ptr);
+	ccs_name_list_len++;
+	ccs_name_live_bytes += ptr->size;
 	return &ptr->entry;
 }
 
+/**
+ * ccs_savename_begin - Start a new generation of ccs_savename().
+ *
+ * Returns nothing.
+ *
+ * Call this before rebuilding everything which holds ccs_savename()'d
+ * pointers, and ccs_savename_reclaim() after that.
+ */
+void ccs_savename_begin(void)
+{
+	ccs_name_generation++;
+	/* Do not mix entries of different generations in an arena. */
+	if (ccs_name_arena)
+		ccs_name_arena->used = ccs_name_arena->size;
+}
+
+/**
+ * ccs_savename_reclaim - Release names which were not used in this generation.
+ *
+ * Returns nothing.
+ *
+ * Pointers returned by ccs_savename() before ccs_savename_begin() must not be
+ * used after this function unless ccs_savename() was called again for them.
+ * Arenas are released when no live entries remain in them.
+ */
+void ccs_savename_reclaim(void)
+{
+	struct ccs_savename_arena **arena = &ccs_name_arena;
+	unsigned int i;
+	for (i = 0; i < ccs_name_list_size; i++) {
+		struct ccs_savename_entry *ptr = ccs_name_list[i];
+		if (!ptr || ptr->generation == ccs_name_generation)
+			continue;
+		ptr->arena->count--;
+		ccs_name_live_bytes -= ptr->size;
+		ccs_name_reclaimed_bytes += ptr->size;
+		ccs_name_list[i] = NULL;
+		ccs_name_list_len--;
+	}
+	/* Removed slots break probe sequences. Rebuild the table. */
+	ccs_savename_rehash(ccs_name_list_size);
+	while (*arena) {
+		struct ccs_savename_arena *ptr = *arena;
+		if (ptr->count) {
+			arena = &ptr->next;
+			continue;
+		}
+		*arena = ptr->next;
+		free(ptr);
+	}
+}
+
+/**
+ * ccs_savename_usage - Get memory usage of ccs_savename().
+ *
+ * @live:      Pointer to "unsigned long" which receives bytes used by names
+ *             which are still remembered.
+ * @reclaimed: Pointer to "unsigned long" which receives bytes used by names
+ *             which were released by ccs_savename_reclaim() so far.
+ *
+ * Returns nothing.
+ */
+void ccs_savename_usage(unsigned long *live, unsigned long *reclaimed)
+{
+	*live = ccs_name_live_bytes;
+	*reclaimed = ccs_name_reclaimed_bytes;
+}
+
 /**
  * ccs_parse_number - Parse a ccs_number_entry.
  *
@@ -1453,9 +1791,9 @@ static void ccs_add_process_entry(const char *line, const pid_t ppid,
 		domain = ccs_strdup(domain);
 	else
 		domain = ccs_strdup("<UNKNOWN>");
+	ccs_task_list = ccs_grow(ccs_task_list, &ccs_task_list_capacity,
+				 ccs_task_list_len, sizeof(struct ccs_task_entry));
 	index = ccs_task_list_len++;
-	ccs_task_list = ccs_realloc(ccs_task_list, ccs_task_list_len *
-				    sizeof(struct ccs_task_entry));
 	memset(&ccs_task_list[index], 0, sizeof(ccs_task_list[0]));
 	ccs_task_list[index].pid = pid;
 	ccs_task_list[index].ppid = ppid;
@@ -2025,8 +2363,13 @@ read_policy:
 	}
 }
 
-/* Is the shared buffer for ccs_freadline() and ccs_shprintf() owned? */
-static _Bool ccs_buffer_locked = false;
+/*
+ * Is the buffer for ccs_freadline() and ccs_shprintf() owned?
+ *
+ * These buffers are per thread. Threads which read policy concurrently should
+ * use their own "struct ccs_reader" instead of ccs_freadline().
+ */
+static __thread _Bool ccs_buffer_locked = false;
 
 /**
  * ccs_get - Mark the shared buffer for ccs_freadline() and ccs_shprintf() owned.
@@ -2058,6 +2401,10 @@ void ccs_put(void)
 	ccs_buffer_locked = false;
 }
 
+/* The buffer returned by ccs_shprintf(). */
+static __thread char *ccs_shprintf_buffer = NULL;
+static __thread int ccs_shprintf_buffer_len = 0;
+
 /**
  * ccs_shprintf - sprintf() to dynamically allocated buffer.
  *
@@ -2065,26 +2412,231 @@ void ccs_put(void)
  *
  * Returns pointer to dynamically allocated buffer.
  *
- * The caller must not free() the returned pointer.
+ * The caller must not free() the returned pointer. Each thread has its own
+ * buffer.
  */
 char *ccs_shprintf(const char *fmt, ...)
 {
 	while (true) {
-		static char *policy = NULL;
-		static int max_policy_len = 0;
 		va_list args;
 		int len;
 		va_start(args, fmt);
-		len = vsnprintf(policy, max_policy_len, fmt, args);
+		len = vsnprintf(ccs_shprintf_buffer, ccs_shprintf_buffer_len,
+				fmt, args);
 		va_end(args);
 		if (len < 0)
 			ccs_out_of_memory();
-		if (len >= max_policy_len) {
-			max_policy_len = len + 1;
-			policy = ccs_realloc(policy, max_policy_len);
+		if (len >= ccs_shprintf_buffer_len) {
+			ccs_shprintf_buffer_len = len + 1;
+			ccs_shprintf_buffer = ccs_realloc(ccs_shprintf_buffer,
+							  ccs_shprintf_buffer_len);
 		} else
-			return policy;
+			return ccs_shprintf_buffer;
+	}
+}
+
+/* Size of a block read by ccs_reader_readline(). */
+#define CCS_FREADLINE_BLOCK_SIZE         65536
+
+/* The reader used by ccs_freadline() and ccs_freadline_unpack(). */
+static __thread struct ccs_reader ccs_default_reader = { };
+
+/**
+ * ccs_reader_fill - Read next block for ccs_reader_readline().
+ *
+ * @reader: Pointer to "struct ccs_reader".
+ * @fp:     Pointer to "FILE".
+ *
+ * Returns true if some data was read, false otherwise.
+ *
+ * Data is read directly from the file descriptor rather than via stdio so that
+ * a whole block can be scanned with memchr().
+ *
+ * Nothing is read once ccs_read_cancelled is set, which lets another thread
+ * abort a long read. Bytes read are added to ccs_read_total for progress.
+ */
+static _Bool ccs_reader_fill(struct ccs_reader *reader, FILE *fp)
+{
+	int fd;
+	int len;
+	/* ccs_reader_spool() has read everything. */
+	if (reader->spooled)
+		return false;
+	fd = fileno(fp);
+	if (!reader->block) {
+		reader->block_size = CCS_FREADLINE_BLOCK_SIZE;
+		reader->block = ccs_malloc(reader->block_size);
 	}
+	if (ccs_read_cancelled)
+		len = 0;
+	else
+		do {
+			len = read(fd, reader->block,
+				   CCS_FREADLINE_BLOCK_SIZE);
+		} while (len == EOF && errno == EINTR);
+	if (len > 0)
+		ccs_read_total += len;
+	reader->head = 0;
+	reader->tail = len > 0 ? len : 0;
+	return len > 0;
+}
+
+/**
+ * ccs_reader_readline - Read a line from file using a reader.
+ *
+ * @reader: Pointer to "struct ccs_reader".
+ * @fp:     Pointer to "FILE".
+ *
+ * Returns pointer to a buffer owned by @reader on success, NULL otherwise.
+ *
+ * The caller must not free() the returned pointer.
+ *
+ * The returned pointer remains valid until next call of this function with
+ * @reader. A line which fits in a block is returned without copying.
+ *
+ * @reader->fingerprint is updated with every line read, which allows callers
+ * to tell whether a stream has changed since the last time. Lines spooled by
+ * ccs_reader_spool() have been hashed already.
+ */
+char *ccs_reader_readline(struct ccs_reader *reader, FILE *fp)
+{
+	char *line;
+	int pos = 0;
+	if (!reader->spooled && fp != reader->fp) {
+		reader->fp = fp;
+		reader->head = 0;
+		reader->tail = 0;
+		reader->fingerprint = 0;
+	}
+	while (true) {
+		char *start;
+		char *cp;
+		int len;
+		if (reader->head == reader->tail &&
+		    !ccs_reader_fill(reader, fp))
+			goto out;
+		start = reader->block + reader->head;
+		len = reader->tail - reader->head;
+		cp = memchr(start, '\n', len);
+		if (cp)
+			len = cp - start;
+		if (ccs_network_mode && memchr(start, '\0', len))
+			goto out;
+		reader->head += len;
+		if (cp && !pos) {
+			/* Return the line in reader->block as is. */
+			reader->head++;
+			*cp = '\0';
+			line = start;
+			pos = len;
+			break;
+		}
+		if (pos + len >= reader->max_line_len) {
+			while (pos + len >= reader->max_line_len)
+				reader->max_line_len += 4096;
+			reader->line = ccs_realloc(reader->line,
+						   reader->max_line_len);
+		}
+		memmove(reader->line + pos, start, len);
+		pos += len;
+		if (cp) {
+			reader->head++;
+			reader->line[pos] = '\0';
+			line = reader->line;
+			break;
+		}
+	}
+	/* Hash lines rather than blocks, for block boundaries may vary. */
+	if (!reader->spooled)
+		reader->fingerprint = reader->fingerprint * 31 +
+			ccs_full_name_hash((const unsigned char *) line, pos);
+	if (!reader->raw)
+		ccs_normalize_line(line);
+	return line;
+out:
+	/* Forget this stream, for the address might be reused. */
+	reader->fp = NULL;
+	reader->head = 0;
+	reader->tail = 0;
+	reader->spooled = false;
+	return NULL;
+}
+
+/**
+ * ccs_reader_spool - Read the rest of a stream into a reader.
+ *
+ * @reader: Pointer to "struct ccs_reader".
+ * @fp:     Pointer to "FILE".
+ *
+ * Returns true on success, false if ccs_read_cancelled was set.
+ *
+ * @reader->fingerprint receives the hash of all lines in @fp, so that the
+ * caller can compare it with the last one before parsing anything. Following
+ * ccs_reader_readline() and ccs_reader_unpack() calls with @reader return the
+ * lines from memory regardless of the stream passed, which may be NULL. The
+ * caller may close @fp as soon as this function returns.
+ */
+_Bool ccs_reader_spool(struct ccs_reader *reader, FILE *fp)
+{
+	const int fd = fileno(fp);
+	char *line;
+	char *cp;
+	if (fp != reader->fp) {
+		reader->fp = fp;
+		reader->head = 0;
+		reader->tail = 0;
+		reader->fingerprint = 0;
+	}
+	if (reader->head) {
+		memmove(reader->block, reader->block + reader->head,
+			reader->tail - reader->head);
+		reader->tail -= reader->head;
+		reader->head = 0;
+	}
+	while (!ccs_read_cancelled) {
+		int len;
+		if (reader->block_size - reader->tail <
+		    CCS_FREADLINE_BLOCK_SIZE) {
+			reader->block_size = reader->block_size ?
+				reader->block_size * 2 :
+				CCS_FREADLINE_BLOCK_SIZE;
+			reader->block = ccs_realloc(reader->block,
+						    reader->block_size);
+		}
+		do {
+			len = read(fd, reader->block + reader->tail,
+				   CCS_FREADLINE_BLOCK_SIZE);
+		} while (len == EOF && errno == EINTR);
+		if (len <= 0)
+			break;
+		ccs_read_total += len;
+		/* The remote host ends the stream with '\0'. */
+		cp = ccs_network_mode ?
+			memchr(reader->block + reader->tail, '\0', len) : NULL;
+		reader->tail += len;
+		if (cp) {
+			reader->tail = cp - reader->block;
+			break;
+		}
+	}
+	if (ccs_read_cancelled) {
+		reader->fp = NULL;
+		reader->head = 0;
+		reader->tail = 0;
+		return false;
+	}
+	/* Hash the lines ccs_reader_readline() will return. */
+	line = reader->block;
+	while ((cp = memchr(line, '\n', reader->tail -
+			    (line - reader->block))) != NULL) {
+		reader->fingerprint = reader->fingerprint * 31 +
+			ccs_full_name_hash((const unsigned char *) line,
+					   cp - line);
+		line = cp + 1;
+	}
+	reader->fp = NULL;
+	reader->spooled = true;
+	return true;
 }
 
 /**
@@ -2095,31 +2647,165 @@ char *ccs_shprintf(const char *fmt, ...)
  * Returns pointer to dynamically allocated buffer on success, NULL otherwise.
  *
  * The caller must not free() the returned pointer.
+ *
+ * The returned pointer remains valid until next call of this function in the
+ * same thread.
  */
 char *ccs_freadline(FILE *fp)
 {
-	static char *policy = NULL;
-	int pos = 0;
-	while (true) {
-		static int max_policy_len = 0;
-		const int c = fgetc(fp);
-		if (c == EOF)
-			return NULL;
-		if (ccs_network_mode && !c)
+	return ccs_reader_readline(&ccs_default_reader, fp);
+}
+
+/**
+ * ccs_clear_reader - Release buffers of a reader.
+ *
+ * @reader: Pointer to "struct ccs_reader".
+ *
+ * Returns nothing.
+ *
+ * @reader can be used again after this function returns.
+ */
+void ccs_clear_reader(struct ccs_reader *reader)
+{
+	free(reader->block);
+	free(reader->line);
+	free(reader->unpacked);
+	memset(reader, 0, sizeof(*reader));
+}
+
+/**
+ * ccs_release_thread_buffers - Release buffers of the calling thread.
+ *
+ * Returns nothing.
+ *
+ * This frees what ccs_freadline(), ccs_freadline_unpack() and ccs_shprintf()
+ * allocated in the calling thread. A thread which used them should call this
+ * before it exits, for these buffers are not freed otherwise.
+ */
+void ccs_release_thread_buffers(void)
+{
+	ccs_clear_reader(&ccs_default_reader);
+	free(ccs_shprintf_buffer);
+	ccs_shprintf_buffer = NULL;
+	ccs_shprintf_buffer_len = 0;
+}
+
+/**
+ * ccs_find_packed_word - Find a word which packs multiple permissions.
+ *
+ * @line: A line to check.
+ * @end:  Pointer to "const char *" which receives the end of the word.
+ *
+ * Returns pointer to the start of the word if @line is packed, NULL otherwise.
+ *
+ * Only "file " and "network " lines, optionally prefixed with
+ * "<$namespace> acl_group $group ", are subjected to unpacking. Lines are
+ * classified by their first byte so that ordinary lines are passed through
+ * without scanning.
+ */
+static const char *ccs_find_packed_word(const char *line, const char **end)
+{
+	const char *pos = line;
+	const char *cp = NULL;
+	unsigned int group;
+	/* Skip "<$namespace> " prefix if followed by "acl_group $group ". */
+	if (*pos == '<') {
+		cp = strchr(pos, ' ');
+		if (!cp || cp[-1] != '>')
 			return NULL;
-		if (pos == max_policy_len) {
-			max_policy_len += 4096;
-			policy = ccs_realloc(policy, max_policy_len);
+		pos = cp + 1;
+	}
+	if (*pos == 'a' && sscanf(pos, "acl_group %u", &group) == 1 &&
+	    group < 256) {
+		cp = strchr(pos + 11, ' ');
+		pos = cp ? cp + 1 : line;
+	} else {
+		pos = line;
+	}
+	cp = NULL;
+	if (*pos == 'f' && !strncmp(pos, "file ", 5)) {
+		cp = pos + 5;
+	} else if (*pos == 'n' && !strncmp(pos, "network ", 8)) {
+		cp = strchr(pos + 8, ' ');
+		if (cp)
+			cp = strchr(cp + 1, ' ');
+		if (cp)
+			cp++;
+	}
+	if (!cp || !*cp)
+		return NULL;
+	*end = strchr(cp + 1, ' ');
+	if (!*end || !memchr(cp, '/', *end - cp))
+		return NULL;
+	return cp;
+}
+
+/**
+ * ccs_reader_unpack - Read a line from file using a reader and unpack it.
+ *
+ * @reader: Pointer to "struct ccs_reader".
+ * @fp:     Pointer to "FILE". Maybe NULL.
+ *
+ * Returns pointer to a buffer owned by @reader on success, NULL otherwise.
+ *
+ * The caller must not free() the returned pointer.
+ *
+ * The caller must repeat calling this function without changing @fp (or with
+ * changing @fp to NULL) until this function returns NULL, for this function
+ * caches a line if the line is packed. Otherwise, some garbage lines might be
+ * returned to the caller.
+ *
+ * A packed line such as "file read/write/append path" is kept in the buffer
+ * of ccs_reader_readline() and each unpacked line is assembled from the
+ * prefix, one permission and the suffix of it into a buffer which is reused.
+ * Empty permissions are ignored.
+ */
+char *ccs_reader_unpack(struct ccs_reader *reader, FILE *fp)
+{
+	while (true) {
+		const char *line = reader->packed_line;
+		const char *pos;
+		const char *cp;
+		int len;
+		if (!line) {
+			const char *end;
+			if (!fp && !reader->spooled)
+				return NULL;
+			line = ccs_reader_readline(reader, fp);
+			if (!line)
+				return NULL;
+			pos = ccs_find_packed_word(line, &end);
+			if (!pos)
+				return (char *) line;
+			reader->packed_line = line;
+			reader->pack_start = pos - line;
+			reader->pack_end = end - line;
+			reader->pack_next = reader->pack_start;
+			reader->suffix_len = strlen(end) + 1;
+			continue;
 		}
-		policy[pos++] = (char) c;
-		if (c == '\n') {
-			policy[--pos] = '\0';
-			break;
+		pos = line + reader->pack_next;
+		cp = memchr(pos, '/', reader->pack_end - reader->pack_next);
+		len = cp ? cp - pos : reader->pack_end - reader->pack_next;
+		if (cp)
+			reader->pack_next += len + 1;
+		else
+			reader->packed_line = NULL;
+		if (!len)
+			continue;
+		if (reader->pack_start + len + reader->suffix_len >
+		    reader->max_unpacked_len) {
+			reader->max_unpacked_len = reader->pack_start + len +
+				reader->suffix_len;
+			reader->unpacked = ccs_realloc(reader->unpacked,
+						       reader->max_unpacked_len);
 		}
+		memcpy(reader->unpacked, line, reader->pack_start);
+		memcpy(reader->unpacked + reader->pack_start, pos, len);
+		memcpy(reader->unpacked + reader->pack_start + len,
+		       line + reader->pack_end, reader->suffix_len);
+		return reader->unpacked;
 	}
-	if (!ccs_freadline_raw)
-		ccs_normalize_line(policy);
-	return policy;
 }
 
 /**
@@ -2138,109 +2824,7 @@ char *ccs_freadline(FILE *fp)
  */
 char *ccs_freadline_unpack(FILE *fp)
 {
-	static char *previous_line = NULL;
-	static char *cached_line = NULL;
-	static int pack_start = 0;
-	static int pack_len = 0;
-	if (cached_line)
-		goto unpack;
-	if (!fp)
-		return NULL;
-	{
-		char *pos;
-		unsigned int offset;
-		unsigned int len;
-		char *line = ccs_freadline(fp);
-		if (!line)
-			return NULL;
-		/*
-		 * Skip
-		 *   <$namespace>
-		 * prefix unless this line represents a domainname.
-		 */
-		if (ccs_domain_def(line) && !ccs_correct_domain(line)) {
-			pos = strchr(line, ' ');
-			if (!pos++)
-				pos = line;
-		} else
-			pos = line;
-		/*
-		 * Skip
-		 *   acl_group $group
-		 * prefix if this line is a line of exception policy.
-		 */
-		if (sscanf(pos, "acl_group %u", &offset) == 1 && offset < 256)
-			pos = strchr(pos + 11, ' ');
-		else
-			pos = NULL;
-		if (pos++)
-			offset = pos - line;
-		else
-			offset = 0;
-		/*
-		 * Only "file " and "network " are subjected to unpacking.
-		 */
-		if (!strncmp(line + offset, "file ", 5)) {
-			char *cp = line + offset + 5;
-			char *cp2 = strchr(cp + 1, ' ');
-			len = cp2 - cp;
-			if (cp2 && memchr(cp, '/', len)) {
-				pack_start = cp - line;
-				goto prepare;
-			}
-		} else if (!strncmp(line + offset, "network ", 8)) {
-			char *cp = strchr(line + offset + 8, ' ');
-			char *cp2 = NULL;
-			if (cp)
-				cp = strchr(cp + 1, ' ');
-			if (cp)
-				cp2 = strchr(cp + 1, ' ');
-			cp++;
-			len = cp2 - cp;
-			if (cp2 && memchr(cp, '/', len)) {
-				pack_start = cp - line;
-				goto prepare;
-			}
-		}
-		return line;
-prepare:
-		pack_len = len;
-		cached_line = ccs_strdup(line);
-	}
-unpack:
-	{
-		char *line = NULL;
-		char *pos = cached_line + pack_start;
-		char *cp = memchr(pos, '/', pack_len);
-		unsigned int len = cp - pos;
-		free(previous_line);
-		previous_line = NULL;
-		if (!cp) {
-			previous_line = cached_line;
-			cached_line = NULL;
-			line = previous_line;
-		} else if (pack_len == 1) {
-			/* Ignore trailing empty word. */
-			free(cached_line);
-			cached_line = NULL;
-		} else {
-			/* Current string is "abc d/e/f ghi". */
-			line = ccs_strdup(cached_line);
-			previous_line = line;
-			/* Overwrite "abc d/e/f ghi" with "abc d ghi". */
-			memmove(line + pack_start + len, pos + pack_len,
-				strlen(pos + pack_len) + 1);
-			/* Overwrite "abc d/e/f ghi" with "abc e/f ghi". */
-			cp++;
-			memmove(pos, cp, strlen(cp) + 1);
-			/* Forget "d/" component. */
-			pack_len -= len + 1;
-			/* Ignore leading and middle empty word. */
-			if (!len)
-				goto unpack;
-		}
-		return line;
-	}
+	return ccs_reader_unpack(&ccs_default_reader, fp);
 }
 
 /**
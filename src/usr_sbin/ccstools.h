@@ -93,6 +93,12 @@ _Bool is_ccs(void);
 #define CCS_PROC_POLICY_QUERY            "/proc/ccs/query"
 #endif /* __GPET */
 
+/* Number of bits in an element of a bitmap. */
+#define CCS_BITS_PER_LONG                ((int) (sizeof(unsigned long) * 8))
+/* Number of elements needed for a bitmap of given bits. */
+#define CCS_BITMAP_LONGS(bits) \
+	(((bits) + CCS_BITS_PER_LONG - 1) / CCS_BITS_PER_LONG)
+
 /***** CONSTANTS DEFINITION END *****/
 
 /***** STRUCTURES DEFINITION START *****/
@@ -151,6 +157,28 @@ struct ccs_task_entry {
 	int depth;
 };
 
+/* State of reading lines from a stream. Zero-initialize before first use. */
+struct ccs_reader {
+	FILE *fp;        /* The stream which "block" holds data for */
+	char *block;     /* Data read from "fp" but not yet returned */
+	int block_size;  /* Size of "block" */
+	int head;        /* Offset of unreturned data in "block" */
+	int tail;        /* Offset of the end of data in "block" */
+	_Bool spooled;   /* "block" holds the rest of a stream */
+	char *line;      /* Buffer for a line which spans blocks */
+	int max_line_len;
+	unsigned int fingerprint; /* Hash of lines read from "fp" */
+	_Bool raw;       /* Don't call ccs_normalize_line() */
+	/* The packed line ccs_reader_unpack() is unpacking. NULL if none. */
+	const char *packed_line;
+	int pack_start;  /* Offset of the packed word in "packed_line" */
+	int pack_end;    /* Offset of the end of the packed word */
+	int pack_next;   /* Offset of the next permission */
+	int suffix_len;  /* Length of the suffix after the packed word */
+	char *unpacked;  /* Buffer for an unpacked line */
+	int max_unpacked_len;
+};
+
 /***** STRUCTURES DEFINITION END *****/
 
 /***** PROTOTYPES DEFINITION START *****/
@@ -169,9 +197,13 @@ _Bool ccs_path_matches_pattern(const struct ccs_path_info *pathname0,
 			       const struct ccs_path_info *pattern0);
 _Bool ccs_pathcmp(const struct ccs_path_info *a,
 		  const struct ccs_path_info *b);
+_Bool ccs_reader_spool(struct ccs_reader *reader, FILE *fp);
 _Bool ccs_str_starts(char *str, const char *begin);
+_Bool ccs_test_bit(const unsigned long *map, const int index);
 char *ccs_freadline(FILE *fp);
 char *ccs_freadline_unpack(FILE *fp);
+char *ccs_reader_readline(struct ccs_reader *reader, FILE *fp);
+char *ccs_reader_unpack(struct ccs_reader *reader, FILE *fp);
 char *ccs_shprintf(const char *fmt, ...)
 	__attribute__ ((format(printf, 1, 2)));
 char *ccs_strdup(const char *string);
@@ -180,6 +212,7 @@ const char *ccs_domain_name(const struct ccs_domain_policy *dp,
 const struct ccs_path_info *ccs_savename(const char *name);
 int ccs_add_string_entry(struct ccs_domain_policy *dp, const char *entry,
 			 const int index);
+int ccs_bitmap_weight(const unsigned long *map, const int len);
 int ccs_assign_domain(struct ccs_domain_policy *dp, const char *domainname,
 		      const _Bool is_dis, const _Bool is_dd);
 int ccs_del_string_entry(struct ccs_domain_policy *dp, const char *entry,
@@ -189,16 +222,24 @@ int ccs_find_domain(const struct ccs_domain_policy *dp,
 		    const _Bool is_dd);
 int ccs_find_domain_by_ptr(struct ccs_domain_policy *dp,
 			   const struct ccs_path_info *domainname);
+int ccs_find_next_bit(const unsigned long *map, const int len, int index);
 int ccs_open_stream(const char *filename);
 int ccs_parse_ip(const char *address, struct ccs_ip_address_entry *entry);
 int ccs_parse_number(const char *number, struct ccs_number_entry *entry);
 int ccs_string_compare(const void *a, const void *b);
 int ccs_write_domain_policy(struct ccs_domain_policy *dp, const int fd);
 struct ccs_path_group_entry *ccs_find_path_group(const char *group_name);
+unsigned long *ccs_bitmap_resize(unsigned long *map, const int len);
+void *ccs_grow(void *ptr, int *capacity, const int len, const size_t size);
 void *ccs_malloc(const size_t size);
 void *ccs_realloc(void *ptr, const size_t size);
 void *ccs_realloc2(void *ptr, const size_t size);
+void ccs_assign_bit(unsigned long *map, const int index, const _Bool value);
+void ccs_assign_bits(unsigned long *map, int start, const int end,
+		     const _Bool value);
+void ccs_change_bit(unsigned long *map, const int index);
 void ccs_clear_domain_policy(struct ccs_domain_policy *dp);
+void ccs_clear_reader(struct ccs_reader *reader);
 void ccs_delete_domain(struct ccs_domain_policy *dp, const int index);
 void ccs_fill_path_info(struct ccs_path_info *ptr);
 void ccs_fprintf_encoded(FILE *fp, const char *ccs_pathname);
@@ -210,12 +251,17 @@ void ccs_put(void);
 void ccs_read_domain_policy(struct ccs_domain_policy *dp,
 			    const char *filename);
 void ccs_read_process_list(_Bool show_all);
+void ccs_release_thread_buffers(void);
+void ccs_savename_begin(void);
+void ccs_savename_reclaim(void);
+void ccs_savename_usage(unsigned long *live, unsigned long *reclaimed);
 
-extern _Bool ccs_freadline_raw;
 extern _Bool ccs_network_mode;
 extern int ccs_task_list_len;
 extern struct ccs_task_entry *ccs_task_list;
 extern u16 ccs_network_port;
 extern u32 ccs_network_ip;
+extern volatile _Bool ccs_read_cancelled;
+extern volatile unsigned long ccs_read_total;
 
 /***** PROTOTYPES DEFINITION END *****/
@@ -26,6 +26,8 @@
 	#include "readline.h"
 #else
 	static char *gpet_line = NULL;
+	/* Called with each domainname read from the domain policy. */
+	static void (*gpet_domain_hook)(const char *domainname) = NULL;
 #endif /* __GPET */
 
 /* Domain policy. */
@@ -38,10 +40,24 @@ static struct ccs_readline_data ccs_rl = { };
 struct ccs_path_group_entry *ccs_path_group_list = NULL;
 /* Length of ccs_path_group_list array. */
 int ccs_path_group_list_len = 0;
+/* Number of elements allocated for ccs_path_group_list array. */
+static int ccs_path_group_list_capacity = 0;
+/* Open addressing index of ccs_path_group_list by namespace and group name. */
+static int *ccs_path_group_hash = NULL;
+/* Number of slots in ccs_path_group_hash array. */
+static int ccs_path_group_hash_size = 0;
 /* Array of string ACL entries. */
 struct ccs_generic_acl *ccs_gacl_list = NULL;
 /* Length of ccs_generic_list array. */
 static int ccs_gacl_list_count = 0;
+/* Number of elements allocated for ccs_gacl_list array. */
+static int ccs_gacl_list_capacity = 0;
+/* Bitmap of selected entries in ccs_gacl_list array. */
+unsigned long *ccs_gacl_selected = NULL;
+/* Open addressing index of ccs_gacl_list array used while reading. */
+static int *ccs_gacl_hash = NULL;
+/* Number of slots in ccs_gacl_hash array. */
+static int ccs_gacl_hash_size = 0;
 
 /* Policy directory. */
 static const char *ccs_policy_dir = NULL;
@@ -72,10 +88,65 @@ static enum ccs_screen_type ccs_previous_screen = CCS_SCREEN_DOMAIN_LIST;
 static struct ccs_transition_control_entry *ccs_transition_control_list = NULL;
 /* Length of ccs_transition_control_list array. */
 static int ccs_transition_control_list_len = 0;
+/* Number of elements allocated for ccs_transition_control_list array. */
+static int ccs_transition_control_list_capacity = 0;
+/* Open addressing index of ccs_transition_control_list array. */
+static struct ccs_transition_control_index *ccs_transition_control_index
+= NULL;
+/* Number of slots in ccs_transition_control_index array. */
+static int ccs_transition_control_index_size = 0;
+/* Number of used slots in ccs_transition_control_index array. */
+static int ccs_transition_control_index_len = 0;
+/* Bitmap of transition types which have entries with a domainname. */
+static u8 ccs_transition_control_domain_types = 0;
+/* Open addressing map from (ns, program) to "from any" transition controls. */
+static struct ccs_assign_djs_entry *ccs_assign_djs_memo = NULL;
+/* Number of slots in ccs_assign_djs_memo array. */
+static int ccs_assign_djs_memo_size = 0;
+/* Number of used slots in ccs_assign_djs_memo array. */
+static int ccs_assign_djs_memo_len = 0;
 /* Sort profiles by value? */
 static _Bool ccs_profile_sort_type = false;
 /* Number of domain jump source domains. */
 static int ccs_unnumbered_domain_count = 0;
+/* Domains in all namespaces. ccs_dp.list points to a range of this array. */
+static struct ccs_domain *ccs_domain_cache = NULL;
+/* Length of ccs_domain_cache array. */
+static int ccs_domain_cache_len = 0;
+/* Number of elements allocated for ccs_domain_cache array. */
+static int ccs_domain_cache_capacity = 0;
+/* Range of ccs_domain_cache for each namespace. */
+static struct ccs_domain_ns_range *ccs_domain_ns_list = NULL;
+/* Length of ccs_domain_ns_list array. */
+static int ccs_domain_ns_list_len = 0;
+/* Number of elements allocated for ccs_domain_ns_list array. */
+static int ccs_domain_ns_list_capacity = 0;
+/* Domains in ccs_dp.list as of the previous reload. */
+static struct ccs_domain_snapshot *ccs_domain_snapshot = NULL;
+/* Length of ccs_domain_snapshot array. */
+static int ccs_domain_snapshot_len = 0;
+/* Number of elements allocated for ccs_domain_snapshot array. */
+static int ccs_domain_snapshot_capacity = 0;
+/* Indexes in ccs_dp.list whose attributes changed by the last reload. */
+static int *ccs_changed_domain_list = NULL;
+/* Length of ccs_changed_domain_list array. */
+static int ccs_changed_domain_len = 0;
+/* Number of elements allocated for ccs_changed_domain_list array. */
+static int ccs_changed_domain_capacity = 0;
+/* Did the last reload add, remove or reorder domains? */
+static _Bool ccs_domain_list_reshaped = true;
+/* Fingerprints of domain policy and exception policy used for ccs_dp. */
+static unsigned int ccs_transition_policy_fingerprint[2] = { };
+/* Namespace shown by ccs_dp. NULL if ccs_dp is not loaded or is stale. */
+static const struct ccs_path_info *ccs_transition_policy_ns = NULL;
+/* State replaced by the last reload, kept until it is released. */
+static struct ccs_transition_state ccs_retired_state = { };
+/* Is ccs_retired_state waiting for ccs_release_transition_state()? */
+static _Bool ccs_transition_state_retired = false;
+/* Fingerprint of the policy used for ccs_gacl_list. */
+static unsigned int ccs_generic_policy_fingerprint = 0;
+/* Was ccs_gacl_list built from the same policy as the previous time? */
+static _Bool ccs_generic_policy_unchanged = false;
 /* Width of CUI screen. */
 static int ccs_window_width = 0;
 /* Height of CUI screen. */
@@ -126,6 +197,12 @@ static const char *ccs_eat(const char *str);
 static const char *ccs_get_last_name(const int index);
 static const struct ccs_transition_control_entry *ccs_transition_control
 (const struct ccs_path_info *ns, const char *domainname, const char *program);
+static const struct ccs_transition_control_entry
+*ccs_resolve_transition_control(const struct ccs_path_info *ns,
+				const struct ccs_path_info *domainname,
+				const struct ccs_path_info *last_name,
+				const struct ccs_path_info *program,
+				const int from_any[]);
 static enum ccs_screen_type ccs_generic_list_loop(void);
 static enum ccs_screen_type ccs_select_window(const int current);
 static int ccs_add_path_group_entry(const struct ccs_path_info *ns,
@@ -141,8 +218,6 @@ static int ccs_add_transition_control_entry(const struct ccs_path_info *ns,
 static int ccs_add_transition_control_policy(const struct ccs_path_info *ns,
 					     char *data, const enum
 					     ccs_transition_type type);
-static int ccs_count(const unsigned char *array, const int len);
-static int ccs_count2(const struct ccs_generic_acl *array, int len);
 static int ccs_domainname_attribute_compare(const void *a, const void *b);
 static int ccs_gacl_compare(const void *a, const void *b);
 static int ccs_gacl_compare0(const void *a, const void *b);
@@ -156,7 +231,9 @@ static int ccs_string_acl_compare(const void *a, const void *b);
 static void ccs_add_entry(void);
 static void ccs_adjust_cursor_pos(const int item_count);
 static void ccs_assign_djs(const struct ccs_path_info *ns,
-			   const char *domainname, const char *program);
+			   const struct ccs_path_info *domainname,
+			   const struct ccs_path_info *last_name,
+			   const struct ccs_path_info *program);
 static void ccs_copy_file(const char *source, const char *dest);
 static void ccs_delete_entry(const int index);
 static void ccs_down_arrow_key(void);
@@ -174,8 +251,207 @@ static void ccs_set_quota(const int current);
 static void ccs_show_current(void);
 static void ccs_show_list(void);
 static void ccs_sigalrm_handler(int sig);
+static void ccs_transition_control_from_any(const struct ccs_path_info *ns,
+					    const struct ccs_path_info *program,
+					    int index[]);
 static void ccs_up_arrow_key(void);
 
+/**
+ * ccs_domain3_hash - Calculate hash value for ccs_dp.hash.
+ *
+ * @domainname: Name of domain. Must be ccs_savename()'d.
+ * @target:     Name of target. Must be ccs_savename()'d. Maybe NULL.
+ * @is_dd:      True if the domain is marked as deleted, false otherwise.
+ *
+ * Returns hash value.
+ */
+static unsigned int ccs_domain3_hash(const struct ccs_path_info *domainname,
+				     const struct ccs_path_info *target,
+				     const _Bool is_dd)
+{
+	unsigned int hash = domainname->hash;
+	if (target)
+		hash ^= target->hash * 31;
+	return hash ^ is_dd;
+}
+
+/**
+ * ccs_hash_domain3 - Register a domain to ccs_dp.hash.
+ *
+ * @index: Index in the ccs_dp.list array.
+ *
+ * Returns nothing.
+ *
+ * The caller must make sure that ccs_dp.hash has room for @index.
+ */
+static void ccs_hash_domain3(const int index)
+{
+	const struct ccs_domain *ptr = &ccs_dp.list[index];
+	const unsigned int mask = ccs_dp.hash_size - 1;
+	unsigned int i = ccs_domain3_hash(ptr->domainname, ptr->target,
+					  ptr->is_dd) & mask;
+	while (ccs_dp.hash[i] != EOF)
+		i = (i + 1) & mask;
+	ccs_dp.hash[i] = index;
+}
+
+/**
+ * ccs_rehash_domain3 - Rebuild ccs_dp.hash.
+ *
+ * Returns nothing.
+ *
+ * Keeps the table at most half full so that a lookup terminates quickly.
+ * Must be called whenever ccs_dp.list is reordered or shrunk. Also updates
+ * "index" of ccs_dp.node.
+ */
+static void ccs_rehash_domain3(void)
+{
+	int i;
+	int size = ccs_dp.hash_size ? ccs_dp.hash_size : 256;
+	while (size < ccs_dp.list_len * 2)
+		size <<= 1;
+	if (size != ccs_dp.hash_size) {
+		free(ccs_dp.hash);
+		ccs_dp.hash = ccs_malloc(size * sizeof(int));
+		ccs_dp.hash_size = size;
+	}
+	for (i = 0; i < size; i++)
+		ccs_dp.hash[i] = EOF;
+	for (i = 0; i < ccs_dp.node_len; i++)
+		ccs_dp.node[i].index = EOF;
+	for (i = 0; i < ccs_dp.list_len; i++) {
+		const struct ccs_domain *ptr = &ccs_dp.list[i];
+		ccs_hash_domain3(i);
+		if (!ptr->target)
+			ccs_dp.node[ptr->node].index = i;
+	}
+}
+
+/**
+ * ccs_domain_node_hash - Calculate hash value for ccs_dp.node_hash.
+ *
+ * @parent: Index of parent node, EOF if none.
+ * @word:   A word in domainname.
+ * @len:    Length of @word.
+ *
+ * Returns hash value.
+ */
+static unsigned int ccs_domain_node_hash(const int parent, const char *word,
+					 int len)
+{
+	unsigned int hash = parent;
+	while (len--)
+		hash = (hash + ((unsigned char) *word++)) * 31;
+	return hash;
+}
+
+/**
+ * ccs_domain_node_slot - Find a slot in ccs_dp.node_hash.
+ *
+ * @parent: Index of parent node, EOF if none.
+ * @word:   A word in domainname.
+ * @len:    Length of @word.
+ *
+ * Returns pointer to the slot which holds the node for @word under @parent
+ * if found, pointer to an unused slot (which holds EOF) otherwise.
+ *
+ * ccs_dp.node_hash_size must not be 0.
+ */
+static int *ccs_domain_node_slot(const int parent, const char *word,
+				 const int len)
+{
+	const unsigned int mask = ccs_dp.node_hash_size - 1;
+	unsigned int i = ccs_domain_node_hash(parent, word, len) & mask;
+	while (ccs_dp.node_hash[i] != EOF) {
+		const struct ccs_domain_node *ptr =
+			&ccs_dp.node[ccs_dp.node_hash[i]];
+		const char *name = ptr->domainname->name + ptr->last_name;
+		if (ptr->parent == parent && !strncmp(name, word, len) &&
+		    !name[len])
+			break;
+		i = (i + 1) & mask;
+	}
+	return &ccs_dp.node_hash[i];
+}
+
+/**
+ * ccs_rehash_domain_node - Rebuild ccs_dp.node_hash.
+ *
+ * Returns nothing.
+ */
+static void ccs_rehash_domain_node(void)
+{
+	int i;
+	int size = ccs_dp.node_hash_size ? ccs_dp.node_hash_size : 256;
+	while (size < (ccs_dp.node_len + 1) * 2)
+		size <<= 1;
+	if (size != ccs_dp.node_hash_size) {
+		free(ccs_dp.node_hash);
+		ccs_dp.node_hash = ccs_malloc(size * sizeof(int));
+		ccs_dp.node_hash_size = size;
+	}
+	for (i = 0; i < size; i++)
+		ccs_dp.node_hash[i] = EOF;
+	for (i = 0; i < ccs_dp.node_len; i++) {
+		const struct ccs_domain_node *ptr = &ccs_dp.node[i];
+		const char *name = ptr->domainname->name + ptr->last_name;
+		*ccs_domain_node_slot(ptr->parent, name, strlen(name)) = i;
+	}
+}
+
+/**
+ * ccs_assign_domain_node - Create nodes for a domainname.
+ *
+ * @domainname: Pointer to "const struct ccs_path_info".
+ *
+ * Returns index of the node for @domainname.
+ *
+ * Nodes for ancestors of @domainname are created as needed.
+ */
+static int ccs_assign_domain_node(const struct ccs_path_info *domainname)
+{
+	const char *name = domainname->name;
+	const char *word = name;
+	int parent = EOF;
+	int depth = 0;
+	while (1) {
+		const char *cp = strchr(word, ' ');
+		const int len = cp ? cp - word : strlen(word);
+		struct ccs_domain_node *ptr;
+		int *slot;
+		if ((ccs_dp.node_len + 1) * 2 > ccs_dp.node_hash_size)
+			ccs_rehash_domain_node();
+		slot = ccs_domain_node_slot(parent, word, len);
+		if (*slot == EOF) {
+			ccs_dp.node = ccs_grow(ccs_dp.node, &ccs_dp.node_capacity,
+					       ccs_dp.node_len,
+					       sizeof(struct ccs_domain_node));
+			*slot = ccs_dp.node_len++;
+			ptr = &ccs_dp.node[*slot];
+			if (cp) {
+				char *line = ccs_strdup(name);
+				line[cp - name] = '\0';
+				ptr->domainname = ccs_savename(line);
+				free(line);
+			} else {
+				ptr->domainname = domainname;
+			}
+			ptr->parent = parent;
+			ptr->depth = depth;
+			ptr->last_name = word - name;
+			ptr->index = EOF;
+			ptr->is_parent = false;
+		}
+		ptr = &ccs_dp.node[*slot];
+		if (!cp)
+			return *slot;
+		ptr->is_parent = true;
+		parent = *slot;
+		depth++;
+		word = cp + 1;
+	}
+}
+
 /**
  * ccs_find_domain3 - Find a domain by name and other attributes.
  *
@@ -188,15 +464,23 @@ static void ccs_up_arrow_key(void);
 static int ccs_find_domain3(const char *domainname, const char *target,
 			    const _Bool is_dd)
 {
-	int i;
-	for (i = 0; i < ccs_dp.list_len; i++) {
-		const struct ccs_domain *ptr = &ccs_dp.list[i];
-		if (ptr->is_dd == is_dd &&
-		    ((!ptr->target && !target) ||
-		     (ptr->target && target &&
-		      !strcmp(ptr->target->name, target))) &&
-		    !strcmp(ptr->domainname->name, domainname))
-			return i;
+	const struct ccs_path_info *name;
+	const struct ccs_path_info *target_name = NULL;
+	unsigned int mask;
+	unsigned int i;
+	if (!ccs_dp.hash_size)
+		return EOF;
+	/* Faster comparison, for they are ccs_savename'd. */
+	name = ccs_savename(domainname);
+	if (target)
+		target_name = ccs_savename(target);
+	mask = ccs_dp.hash_size - 1;
+	for (i = ccs_domain3_hash(name, target_name, is_dd) & mask;
+	     ccs_dp.hash[i] != EOF; i = (i + 1) & mask) {
+		const struct ccs_domain *ptr = &ccs_dp.list[ccs_dp.hash[i]];
+		if (ptr->domainname == name && ptr->target == target_name &&
+		    ptr->is_dd == is_dd)
+			return ccs_dp.hash[i];
 	}
 	return EOF;
 }
@@ -210,13 +494,10 @@ static int ccs_find_domain3(const char *domainname, const char *target,
  */
 static struct ccs_domain *ccs_find_domain3_by_name(const char *domainname)
 {
-	int i;
-	for (i = 0; i < ccs_dp.list_len; i++) {
-		struct ccs_domain *ptr = &ccs_dp.list[i];
-		if (!ptr->target && !strcmp(ptr->domainname->name, domainname))
-			return ptr;
-	}
-	return NULL;
+	int index = ccs_find_domain3(domainname, NULL, false);
+	if (index == EOF)
+		index = ccs_find_domain3(domainname, NULL, true);
+	return index != EOF ? &ccs_dp.list[index] : NULL;
 }
 
 /**
@@ -236,18 +517,70 @@ static int ccs_assign_domain3(const char *domainname, const char *target,
 	int index = ccs_find_domain3(domainname, target, is_dd);
 	if (index >= 0)
 		return index;
+	/* ccs_dp.list covers all of ccs_domain_cache while loading. */
+	ccs_domain_cache = ccs_grow(ccs_domain_cache,
+				    &ccs_domain_cache_capacity,
+				    ccs_domain_cache_len,
+				    sizeof(struct ccs_domain));
+	ccs_dp.list = ccs_domain_cache;
 	index = ccs_dp.list_len++;
-	ccs_dp.list = ccs_realloc(ccs_dp.list, ccs_dp.list_len *
-				  sizeof(struct ccs_domain));
+	ccs_domain_cache_len = ccs_dp.list_len;
 	ptr = &ccs_dp.list[index];
 	memset(ptr, 0, sizeof(*ptr));
 	ptr->domainname = ccs_savename(domainname);
 	if (target)
 		ptr->target = ccs_savename(target);
 	ptr->is_dd = is_dd;
+	ptr->node = ccs_assign_domain_node(ptr->domainname);
+	if (!target)
+		ccs_dp.node[ptr->node].index = index;
+	if (ccs_dp.list_len * 2 > ccs_dp.hash_size)
+		ccs_rehash_domain3();
+	else
+		ccs_hash_domain3(index);
 	return index;
 }
 
+/**
+ * ccs_string_entry_slot - Find a slot in the hash set of string entries.
+ *
+ * @ptr:   Pointer to "const struct ccs_domain_strings".
+ * @entry: Pointer to "const struct ccs_path_info". Must be ccs_savename()'d.
+ *
+ * Returns pointer to the slot which holds @entry if found, pointer to an
+ * unused slot (which holds NULL) otherwise.
+ */
+static const struct ccs_path_info **ccs_string_entry_slot
+(const struct ccs_domain_strings *ptr, const struct ccs_path_info *entry)
+{
+	const unsigned int mask = ptr->string_hash_size - 1;
+	unsigned int i = entry->hash & mask;
+	/* Faster comparison, for they are ccs_savename'd. */
+	while (ptr->string_hash[i] && ptr->string_hash[i] != entry)
+		i = (i + 1) & mask;
+	return &ptr->string_hash[i];
+}
+
+/**
+ * ccs_rehash_string_entry - Rebuild "struct ccs_domain_strings"->string_hash.
+ *
+ * @ptr:  Pointer to "struct ccs_domain_strings".
+ * @size: Number of slots. Must be a power of 2.
+ *
+ * Returns nothing.
+ */
+static void ccs_rehash_string_entry(struct ccs_domain_strings *ptr,
+				    const int size)
+{
+	int i;
+	free(ptr->string_hash);
+	ptr->string_hash = ccs_malloc(size * sizeof(*ptr->string_hash));
+	ptr->string_hash_size = size;
+	for (i = 0; i < ptr->string_count; i++)
+		*ccs_string_entry_slot(ptr, ptr->string_ptr[i]) =
+			ptr->string_ptr[i];
+}
+
 /**
  * ccs_add_string_entry - Add string entry to a domain.
  *
@@ -258,6 +591,7 @@ static int ccs_assign_domain3(const char *domainname, const char *target,
  */
 static int ccs_add_string_entry3(const char *entry, const int index)
 {
+	struct ccs_domain_strings *ptr;
 	const struct ccs_path_info **acl_ptr;
 	int acl_count;
 	const struct ccs_path_info *cp;
@@ -270,23 +604,58 @@ static int ccs_add_string_entry3(const char *entry, const int index)
 		return -EINVAL;
 	cp = ccs_savename(entry);
 
-	acl_ptr = ccs_dp.list[index].string_ptr;
-	acl_count = ccs_dp.list[index].string_count;
+	ptr = ccs_dp.list[index].strings;
+	if (!ptr) {
+		ptr = ccs_malloc(sizeof(*ptr));
+		ccs_dp.list[index].strings = ptr;
+	}
+	acl_ptr = ptr->string_ptr;
+	acl_count = ptr->string_count;
 
-	/* Check for the same entry. */
-	for (i = 0; i < acl_count; i++)
-		/* Faster comparison, for they are ccs_savename'd. */
-		if (cp == acl_ptr[i])
+	/*
+	 * Check for the same entry. Domains which execute many programs are
+	 * checked using a hash table, others are checked by linear search.
+	 */
+	if (ptr->string_hash) {
+		if (*ccs_string_entry_slot(ptr, cp))
 			return 0;
+	} else {
+		for (i = 0; i < acl_count; i++)
+			/* Faster comparison, for they are ccs_savename'd. */
+			if (cp == acl_ptr[i])
+				return 0;
+	}
 
-	acl_ptr = ccs_realloc(acl_ptr, (acl_count + 1) *
-			      sizeof(const struct ccs_path_info *));
+	acl_ptr = ccs_grow(acl_ptr, &ptr->string_capacity, acl_count,
+			   sizeof(const struct ccs_path_info *));
 	acl_ptr[acl_count++] = cp;
-	ccs_dp.list[index].string_ptr = acl_ptr;
-	ccs_dp.list[index].string_count = acl_count;
+	ptr->string_ptr = acl_ptr;
+	ptr->string_count = acl_count;
+	if (acl_count * 2 > ptr->string_hash_size && acl_count >= 16)
+		ccs_rehash_string_entry(ptr, ptr->string_hash_size ?
+					ptr->string_hash_size * 2 : 64);
+	else if (ptr->string_hash)
+		*ccs_string_entry_slot(ptr, cp) = cp;
 	return 0;
 }
 
+/**
+ * ccs_free_string_entry3 - Release string entries of a domain.
+ *
+ * @ptr: Pointer to "struct ccs_domain".
+ *
+ * Returns nothing.
+ */
+static void ccs_free_string_entry3(struct ccs_domain *ptr)
+{
+	if (!ptr->strings)
+		return;
+	free(ptr->strings->string_ptr);
+	free(ptr->strings->string_hash);
+	free(ptr->strings);
+	ptr->strings = NULL;
+}
+
 /**
  * ccs_clear_domain_policy3 - Clean up domain policy.
  *
@@ -295,14 +664,18 @@ static int ccs_add_string_entry3(const char *entry, const int index)
 static void ccs_clear_domain_policy3(void)
 {
 	int index;
-	for (index = 0; index < ccs_dp.list_len; index++) {
-		free(ccs_dp.list[index].string_ptr);
-		ccs_dp.list[index].string_ptr = NULL;
-		ccs_dp.list[index].string_count = 0;
-	}
-	free(ccs_dp.list);
+	for (index = 0; index < ccs_domain_cache_len; index++)
+		ccs_free_string_entry3(&ccs_domain_cache[index]);
+	free(ccs_domain_cache);
+	ccs_domain_cache = NULL;
+	ccs_domain_cache_len = 0;
+	ccs_domain_cache_capacity = 0;
+	ccs_domain_ns_list_len = 0;
 	ccs_dp.list = NULL;
 	ccs_dp.list_len = 0;
+	ccs_dp.node_len = 0;
+	ccs_rehash_domain3();
+	ccs_rehash_domain_node();
 }
 
 /**
@@ -400,43 +773,8 @@ static const char *ccs_get_last_word(const char *line)
  */
 static const char *ccs_get_last_name(const int index)
 {
-	return ccs_get_last_word(ccs_dp.list[index].domainname->name);
-}
-
-/**
- * ccs_count - Count non-zero elements in an array.
- *
- * @array: Pointer to "const unsigned char".
- * @len:   Length of @array array.
- *
- * Returns number of non-zero elements.
- */
-static int ccs_count(const unsigned char *array, const int len)
-{
-	int i;
-	int c = 0;
-	for (i = 0; i < len; i++)
-		if (array[i])
-			c++;
-	return c;
-}
-
-/**
- * ccs_count2 - Count non-zero elements in a "struct ccs_generic_acl" array.
- *
- * @array: Pointer to "const struct ccs_generic_acl".
- * @len:   Length of @array array.
- *
- * Returns number of non-zero elements.
- */
-static int ccs_count2(const struct ccs_generic_acl *array, int len)
-{
-	int i;
-	int c = 0;
-	for (i = 0; i < len; i++)
-		if (array[i].selected)
-			c++;
-	return c;
+	const struct ccs_domain *ptr = &ccs_dp.list[index];
+	return ptr->domainname->name + ccs_dp.node[ptr->node].last_name;
 }
 
 /**
@@ -602,18 +940,92 @@ static int ccs_add_path_group_policy(const struct ccs_path_info *ns,
 	return ccs_add_path_group_entry(ns, data, cp, is_delete);
 }
 
+/**
+ * ccs_assign_djs_slot - Find a slot in ccs_assign_djs_memo.
+ *
+ * @ns:      Pointer to "const struct ccs_path_info".
+ * @program: Pointer to "const struct ccs_path_info".
+ *
+ * Returns pointer to the slot which holds the given pair if found, pointer to
+ * an unused slot otherwise.
+ *
+ * All arguments must be ccs_savename()'d. ccs_assign_djs_memo_size must not
+ * be 0.
+ */
+static struct ccs_assign_djs_entry *ccs_assign_djs_slot
+(const struct ccs_path_info *ns, const struct ccs_path_info *program)
+{
+	const unsigned int mask = ccs_assign_djs_memo_size - 1;
+	unsigned int i = (ns->hash * 31 + program->hash) & mask;
+	while (1) {
+		struct ccs_assign_djs_entry *ptr = &ccs_assign_djs_memo[i];
+		/* Faster comparison, for they are ccs_savename'd. */
+		if (!ptr->ns || (ptr->ns == ns && ptr->program == program))
+			return ptr;
+		i = (i + 1) & mask;
+	}
+}
+
+/**
+ * ccs_clear_assign_djs_memo - Forget pairs remembered by ccs_assign_djs().
+ *
+ * Returns nothing.
+ */
+static void ccs_clear_assign_djs_memo(void)
+{
+	free(ccs_assign_djs_memo);
+	ccs_assign_djs_memo = NULL;
+	ccs_assign_djs_memo_len = 0;
+	ccs_assign_djs_memo_size = 0;
+}
+
 /**
  * ccs_assign_djs - Assign domain jump source domain.
  *
  * @ns:         Pointer to "const struct ccs_path_info".
- * @domainname: Domainname.
- * @program:    Program name.
+ * @domainname: Pointer to "const struct ccs_path_info".
+ * @last_name:  Pointer to "const struct ccs_path_info" of the last word of
+ *              @domainname.
+ * @program:    Pointer to "const struct ccs_path_info".
+ *
+ * Returns nothing.
+ *
+ * Most transition controls apply to any domain, and the same programs (e.g.
+ * "path_group" members) are executed from many domains. The entries which
+ * apply to any domain are therefore looked up once per namespace and program,
+ * and remembered in ccs_assign_djs_memo until ccs_clear_assign_djs_memo() is
+ * called. Only entries with a domainname are looked up for each domain.
  */
 static void ccs_assign_djs(const struct ccs_path_info *ns,
-			   const char *domainname, const char *program)
+			   const struct ccs_path_info *domainname,
+			   const struct ccs_path_info *last_name,
+			   const struct ccs_path_info *program)
 {
-	const struct ccs_transition_control_entry *d_t =
-		ccs_transition_control(ns, domainname, program);
+	const struct ccs_transition_control_entry *d_t;
+	struct ccs_assign_djs_entry *entry;
+	if ((ccs_assign_djs_memo_len + 1) * 2 > ccs_assign_djs_memo_size) {
+		struct ccs_assign_djs_entry *old = ccs_assign_djs_memo;
+		const int old_size = ccs_assign_djs_memo_size;
+		int i;
+		ccs_assign_djs_memo_size = old_size ? old_size * 2 : 1024;
+		ccs_assign_djs_memo =
+			ccs_malloc(ccs_assign_djs_memo_size *
+				   sizeof(struct ccs_assign_djs_entry));
+		for (i = 0; i < old_size; i++)
+			if (old[i].ns)
+				*ccs_assign_djs_slot(old[i].ns,
+						     old[i].program) = old[i];
+		free(old);
+	}
+	entry = ccs_assign_djs_slot(ns, program);
+	if (!entry->ns) {
+		entry->ns = ns;
+		entry->program = program;
+		ccs_transition_control_from_any(ns, program, entry->index);
+		ccs_assign_djs_memo_len++;
+	}
+	d_t = ccs_resolve_transition_control(ns, domainname, last_name,
+					     program, entry->index);
 	if (!d_t)
 		return;
 	if (d_t->type == CCS_TRANSITION_CONTROL_INITIALIZE ||
@@ -622,21 +1034,43 @@ static void ccs_assign_djs(const struct ccs_path_info *ns,
 		char *cp;
 		ccs_get();
 		if (d_t->type == CCS_TRANSITION_CONTROL_INITIALIZE)
-			line = ccs_shprintf("%s %s", domainname, program);
+			line = ccs_shprintf("%s %s", domainname->name,
+					    program->name);
 		else
-			line = ccs_shprintf("%s <%s>", domainname, program);
+			line = ccs_shprintf("%s <%s>", domainname->name,
+					    program->name);
 		ccs_normalize_line(line);
 		cp = ccs_strdup(line);
 		if (d_t->type == CCS_TRANSITION_CONTROL_INITIALIZE)
-			line = ccs_shprintf("%s %s", ns->name, program);
+			line = ccs_shprintf("%s %s", ns->name, program->name);
 		else
-			line = ccs_shprintf("<%s>", program);
+			line = ccs_shprintf("<%s>", program->name);
 		ccs_assign_domain3(cp, line, false);
 		free(cp);
 		ccs_put();
 	}
 }
 
+/**
+ * ccs_domain_sort_key - Get the name used for sorting a domain.
+ *
+ * @ptr: Pointer to "const struct ccs_domain".
+ *
+ * Returns the domainname for a domain, the parent's domainname for a domain
+ * jump source.
+ *
+ * The parent's domainname is taken from ccs_dp.node so that no string needs
+ * to be built while sorting.
+ */
+static const struct ccs_path_info *ccs_domain_sort_key
+(const struct ccs_domain *ptr)
+{
+	const int parent = ccs_dp.node[ptr->node].parent;
+	if (ptr->target && parent != EOF)
+		return ccs_dp.node[parent].domainname;
+	return ptr->domainname;
+}
+
 /**
  * ccs_domainname_attribute_compare - strcmp() for qsort() callback.
  *
@@ -644,52 +1078,29 @@ static void ccs_assign_djs(const struct ccs_path_info *ns,
  * @b: Pointer to "void".
  *
  * Returns return value of strcmp().
+ *
+ * A domain jump source is sorted as if it were named "$parent $target" where
+ * $parent is the domainname of its parent and $target is the jump target.
  */
 static int ccs_domainname_attribute_compare(const void *a, const void *b)
 {
 	const struct ccs_domain *a0 = a;
 	const struct ccs_domain *b0 = b;
-	char *name1;
-	char *name2;
-	char *line;
-	char *cp;
+	const struct ccs_path_info *name1;
+	const struct ccs_path_info *name2;
 	int k;
 	if (!a0->target && !b0->target)
 		return strcmp(a0->domainname->name, b0->domainname->name);
-	name1 = ccs_strdup(a0->domainname->name);
-	if (a0->target) {
-		cp = strrchr(name1, ' ');
-		if (cp)
-			*cp = '\0';
-	}
-	name2 = ccs_strdup(b0->domainname->name);
-	if (b0->target) {
-		cp = strrchr(name2, ' ');
-		if (cp)
-			*cp = '\0';
-	}
-	k = strcmp(name1, name2);
+	name1 = ccs_domain_sort_key(a0);
+	name2 = ccs_domain_sort_key(b0);
+	k = name1 == name2 ? 0 : strcmp(name1->name, name2->name);
 	if (k)
-		goto done;
-	ccs_get();
-	if (a0->target)
-		line = ccs_shprintf("%s %s", name1, a0->target->name);
-	else
-		line = ccs_shprintf("%s", name1);
-	free(name1);
-	name1 = ccs_strdup(line);
-	if (b0->target)
-		line = ccs_shprintf("%s %s", name2, b0->target->name);
-	else
-		line = ccs_shprintf("%s", name2);
-	free(name2);
-	name2 = ccs_strdup(line);
-	ccs_put();
-	k = strcmp(name1, name2);
-done:
-	free(name1);
-	free(name2);
-	return k;
+		return k;
+	if (!a0->target)
+		return -1;
+	if (!b0->target)
+		return 1;
+	return strcmp(a0->target->name, b0->target->name);
 }
 
 /**
@@ -699,16 +1110,12 @@ done:
  *
  * Returns index of the domain if found in a current namespace,
  * -2 if found in a different namespace, EOF otherwise.
+ *
+ * The target is looked up by ccs_select_domain_namespace().
  */
 static int ccs_find_target_domain(const int index)
 {
-	const char *cp = ccs_dp.list[index].target->name;
-	if (!ccs_is_current_namespace(cp)) {
-		if (ccs_dp.list[index].is_du)
-			return EOF;
-		return -2;
-	}
-	return ccs_find_domain3(cp, NULL, false);
+	return ccs_dp.list[index].redirect;
 }
 
 /**
@@ -729,8 +1136,9 @@ static int ccs_show_domain_line(const int index)
 	const bool is_djs = ccs_jump_source(index);
 	const bool is_deleted = ccs_deleted_domain(index);
 	if (number >= 0)
-		printw("%c%4d:%3u %c%c%c ", ccs_dp.list_selected[index] ? '&' :
-		       ' ', number, ccs_dp.list[index].profile,
+		printw("%c%4d:%3u %c%c%c ",
+		       ccs_test_bit(ccs_dp.list_selected, index) ? '&' : ' ',
+		       number, ccs_dp.list[index].profile,
 		       ccs_keeper_domain(index) ? '#' : ' ',
 		       ccs_jump_target(index) ? '*' : ' ',
 		       ccs_domain_unreachable(index) ? '!' : ' ');
@@ -814,7 +1222,7 @@ static int ccs_show_acl_line(const int index, const int list_indent)
 	const char *cp2 = ccs_gacl_list[index].operand;
 	int len = list_indent - ccs_directives[directive].alias_len;
 	printw("%c%4d: %s ",
-	       ccs_gacl_list[index].selected ? '&' : ' ',
+	       ccs_test_bit(ccs_gacl_selected, index) ? '&' : ' ',
 	       index, ccs_eat(cp1));
 	while (len-- > 0)
 		printw("%s", ccs_eat(" "));
@@ -836,7 +1244,7 @@ static int ccs_show_profile_line(const int index)
 	char number[8] = "";
 	if (profile <= 256)
 		snprintf(number, sizeof(number) - 1, "%3u-", profile);
-	printw("%c%4d: %s", ccs_gacl_list[index].selected ? '&' : ' ',
+	printw("%c%4d: %s", ccs_test_bit(ccs_gacl_selected, index) ? '&' : ' ',
 	       index, ccs_eat(number));
 	printw("%s ", ccs_eat(cp));
 	return strlen(number) + strlen(cp) + 8;
@@ -853,7 +1261,7 @@ static int ccs_show_literal_line(const int index)
 {
 	const char *cp = ccs_gacl_list[index].operand;
 	printw("%c%4d: %s ",
-	       ccs_gacl_list[index].selected ? '&' : ' ',
+	       ccs_test_bit(ccs_gacl_selected, index) ? '&' : ' ',
 	       index, ccs_eat(cp));
 	return strlen(cp) + 8;
 }
@@ -1105,94 +1513,320 @@ static const char *ccs_eat(const char *str)
 }
 
 /**
- * ccs_transition_control - Find domain transition control.
+ * ccs_transition_control_hash - Calculate hash value for ccs_transition_control_index.
  *
  * @ns:         Pointer to "const struct ccs_path_info".
- * @domainname: Domainname.
- * @program:    Program name.
+ * @domainname: Pointer to "const struct ccs_path_info". Maybe NULL.
+ * @program:    Pointer to "const struct ccs_path_info". Maybe NULL.
+ * @type:       One of values in "enum ccs_transition_type".
+ * @key:        One of values in "enum ccs_transition_control_key".
  *
- * Returns pointer to "const struct ccs_transition_control_entry" if found one,
- * NULL otherwise.
+ * Returns hash value.
  */
-static const struct ccs_transition_control_entry *ccs_transition_control
-(const struct ccs_path_info *ns, const char *domainname, const char *program)
+static unsigned int ccs_transition_control_hash
+(const struct ccs_path_info *ns, const struct ccs_path_info *domainname,
+ const struct ccs_path_info *program, const u8 type, const u8 key)
 {
-	int i;
-	u8 type;
-	struct ccs_path_info domain;
-	struct ccs_path_info last_name;
-	domain.name = domainname;
-	last_name.name = ccs_get_last_word(domainname);
-	ccs_fill_path_info(&domain);
-	ccs_fill_path_info(&last_name);
-	for (type = 0; type < CCS_MAX_TRANSITION_TYPE; type++) {
-next:
-		for (i = 0; i < ccs_transition_control_list_len; i++) {
-			struct ccs_transition_control_entry *ptr
-				= &ccs_transition_control_list[i];
-			if (ptr->type != type)
-				continue;
-			if (ccs_pathcmp(ptr->ns, ns))
-				continue;
-			if (ptr->domainname &&
-			    ccs_pathcmp(ptr->domainname, &domain) &&
-			    ccs_pathcmp(ptr->domainname, &last_name))
-				continue;
-			if (ptr->program &&
-			    strcmp(ptr->program->name, program))
-				continue;
-			if (type == CCS_TRANSITION_CONTROL_NO_RESET) {
-				/*
-				 * Do not check for reset_domain if
-				 * no_reset_domain matched.
-				 */
-				type = CCS_TRANSITION_CONTROL_NO_INITIALIZE;
-				goto next;
-			}
-			if (type == CCS_TRANSITION_CONTROL_NO_INITIALIZE) {
-				/*
-				 * Do not check for initialize_domain if
-				 * no_initialize_domain matched.
-				 */
-				type = CCS_TRANSITION_CONTROL_NO_KEEP;
-				goto next;
-			}
-			if (type == CCS_TRANSITION_CONTROL_RESET ||
-			    type == CCS_TRANSITION_CONTROL_INITIALIZE ||
-			    type == CCS_TRANSITION_CONTROL_KEEP)
-				return ptr;
-			else
-				return NULL;
-		}
-	}
-	return NULL;
+	unsigned int hash = ns->hash;
+	hash = hash * 31 + type * CCS_MAX_TRANSITION_CONTROL_KEY + key;
+	hash = hash * 31 + (domainname ? domainname->hash : 0);
+	return hash * 31 + (program ? program->hash : 0);
 }
 
 /**
- * ccs_profile_entry_compare -  strcmp() for qsort() callback.
+ * ccs_transition_control_slot - Find a slot in ccs_transition_control_index.
  *
- * @a: Pointer to "void".
- * @b: Pointer to "void".
+ * @ns:         Pointer to "const struct ccs_path_info".
+ * @domainname: Pointer to "const struct ccs_path_info". Maybe NULL.
+ * @program:    Pointer to "const struct ccs_path_info". Maybe NULL.
+ * @type:       One of values in "enum ccs_transition_type".
+ * @key:        One of values in "enum ccs_transition_control_key".
  *
- * Returns return value of strcmp().
+ * Returns pointer to the slot which holds the given key if found, pointer to
+ * an unused slot otherwise.
+ *
+ * ccs_transition_control_index_size must not be 0.
  */
-static int ccs_profile_entry_compare(const void *a, const void *b)
+static struct ccs_transition_control_index *ccs_transition_control_slot
+(const struct ccs_path_info *ns, const struct ccs_path_info *domainname,
+ const struct ccs_path_info *program, const u8 type, const u8 key)
 {
-	const struct ccs_generic_acl *a0 = (struct ccs_generic_acl *) a;
-	const struct ccs_generic_acl *b0 = (struct ccs_generic_acl *) b;
-	const char *a1 = a0->operand;
-	const char *b1 = b0->operand;
-	const int a2 = a0->directive;
-	const int b2 = b0->directive;
-	if (a2 >= 256 || b2 >= 256) {
-		if (a1[0] == 'P')
-			return -1;
-		if (b1[0] == 'P')
-			return 1;
+	const unsigned int mask = ccs_transition_control_index_size - 1;
+	unsigned int i = ccs_transition_control_hash(ns, domainname, program,
+						     type, key) & mask;
+	while (1) {
+		struct ccs_transition_control_index *ptr =
+			&ccs_transition_control_index[i];
+		if (!ptr->ns)
+			return ptr;
+		if (ptr->type == type && ptr->key == key &&
+		    !ccs_pathcmp(ptr->ns, ns) &&
+		    (ptr->domainname == domainname ||
+		     (ptr->domainname && domainname &&
+		      !ccs_pathcmp(ptr->domainname, domainname))) &&
+		    (ptr->program == program ||
+		     (ptr->program && program &&
+		      !ccs_pathcmp(ptr->program, program))))
+			return ptr;
+		i = (i + 1) & mask;
 	}
-	if (!ccs_profile_sort_type) {
-		if (a2 == b2)
-			return strcmp(a1, b1);
+}
+
+/**
+ * ccs_find_transition_control - Find the first matching transition control.
+ *
+ * @ns:         Pointer to "const struct ccs_path_info".
+ * @domainname: Pointer to "const struct ccs_path_info". NULL for "any".
+ * @program:    Pointer to "const struct ccs_path_info". NULL for "any".
+ * @type:       One of values in "enum ccs_transition_type".
+ * @key:        One of values in "enum ccs_transition_control_key".
+ *
+ * Returns index in ccs_transition_control_list array if found, EOF otherwise.
+ */
+static int ccs_find_transition_control
+(const struct ccs_path_info *ns, const struct ccs_path_info *domainname,
+ const struct ccs_path_info *program, const u8 type, const u8 key)
+{
+	const struct ccs_transition_control_index *ptr;
+	if (!ccs_transition_control_index_len)
+		return EOF;
+	ptr = ccs_transition_control_slot(ns, domainname, program, type, key);
+	return ptr->ns ? ptr->index : EOF;
+}
+
+/**
+ * ccs_first_transition_control - Choose the earlier one.
+ *
+ * @index1: Index in ccs_transition_control_list array or EOF.
+ * @index2: Index in ccs_transition_control_list array or EOF.
+ *
+ * Returns the smaller index which is not EOF, EOF if both are EOF.
+ */
+static int ccs_first_transition_control(const int index1, const int index2)
+{
+	if (index1 == EOF)
+		return index2;
+	if (index2 == EOF || index1 < index2)
+		return index1;
+	return index2;
+}
+
+/**
+ * ccs_index_transition_control - Add a transition control to ccs_transition_control_index.
+ *
+ * @index: Index in ccs_transition_control_list array.
+ *
+ * Returns nothing.
+ *
+ * Each entry is registered with three keys, one comparing both domainname and
+ * program, one comparing program only and one comparing domainname only. Only
+ * the first entry is remembered for each key, for lookups want the first
+ * matching entry in ccs_transition_control_list array.
+ */
+static void ccs_index_transition_control(const int index)
+{
+	const struct ccs_transition_control_entry *entry =
+		&ccs_transition_control_list[index];
+	u8 key;
+	if ((ccs_transition_control_index_len + CCS_MAX_TRANSITION_CONTROL_KEY)
+	    * 2 > ccs_transition_control_index_size) {
+		struct ccs_transition_control_index *old =
+			ccs_transition_control_index;
+		const int old_size = ccs_transition_control_index_size;
+		int i;
+		ccs_transition_control_index_size = old_size ?
+			old_size * 2 : 256;
+		ccs_transition_control_index =
+			ccs_malloc(ccs_transition_control_index_size *
+				   sizeof(struct ccs_transition_control_index));
+		for (i = 0; i < old_size; i++) {
+			if (old[i].ns)
+				*ccs_transition_control_slot
+					(old[i].ns, old[i].domainname,
+					 old[i].program, old[i].type,
+					 old[i].key) = old[i];
+		}
+		free(old);
+	}
+	for (key = 0; key < CCS_MAX_TRANSITION_CONTROL_KEY; key++) {
+		const struct ccs_path_info *domainname =
+			key != CCS_TRANSITION_CONTROL_KEY_PROGRAM ?
+			entry->domainname : NULL;
+		const struct ccs_path_info *program =
+			key != CCS_TRANSITION_CONTROL_KEY_DOMAIN ?
+			entry->program : NULL;
+		struct ccs_transition_control_index *ptr =
+			ccs_transition_control_slot(entry->ns, domainname,
+						    program, entry->type, key);
+		if (ptr->ns)
+			continue;
+		ptr->ns = entry->ns;
+		ptr->domainname = domainname;
+		ptr->program = program;
+		ptr->type = entry->type;
+		ptr->key = key;
+		ptr->index = index;
+		ccs_transition_control_index_len++;
+	}
+	if (entry->domainname)
+		ccs_transition_control_domain_types |= 1 << entry->type;
+}
+
+/**
+ * ccs_transition_control_from_any - Find domain transition controls for any domain.
+ *
+ * @ns:      Pointer to "const struct ccs_path_info".
+ * @program: Pointer to "const struct ccs_path_info".
+ * @index:   Array of CCS_MAX_TRANSITION_TYPE elements.
+ *
+ * Returns nothing.
+ *
+ * @index[type] receives the index in ccs_transition_control_list array of the
+ * first entry of that type whose domainname is "any" and whose program is
+ * "any" or @program, EOF if none. These do not depend on the domain.
+ */
+static void ccs_transition_control_from_any(const struct ccs_path_info *ns,
+					    const struct ccs_path_info *program,
+					    int index[])
+{
+	u8 type;
+	for (type = 0; type < CCS_MAX_TRANSITION_TYPE; type++)
+		index[type] = ccs_first_transition_control
+			(ccs_find_transition_control
+			 (ns, NULL, program, type,
+			  CCS_TRANSITION_CONTROL_KEY_EXACT),
+			 ccs_find_transition_control
+			 (ns, NULL, NULL, type,
+			  CCS_TRANSITION_CONTROL_KEY_EXACT));
+}
+
+/**
+ * ccs_resolve_transition_control - Find domain transition control.
+ *
+ * @ns:         Pointer to "const struct ccs_path_info".
+ * @domainname: Pointer to "const struct ccs_path_info".
+ * @last_name:  Pointer to "const struct ccs_path_info" of the last word of
+ *              @domainname.
+ * @program:    Pointer to "const struct ccs_path_info".
+ * @from_any:   Array filled by ccs_transition_control_from_any() for @ns
+ *              and @program.
+ *
+ * Returns pointer to "const struct ccs_transition_control_entry" if found one,
+ * NULL otherwise.
+ */
+static const struct ccs_transition_control_entry
+*ccs_resolve_transition_control(const struct ccs_path_info *ns,
+				const struct ccs_path_info *domainname,
+				const struct ccs_path_info *last_name,
+				const struct ccs_path_info *program,
+				const int from_any[])
+{
+	const struct ccs_path_info *names[2] = { domainname, last_name };
+	u8 type;
+	for (type = 0; type < CCS_MAX_TRANSITION_TYPE; type++) {
+		const struct ccs_transition_control_entry *ptr;
+		int index;
+		int i;
+next:
+		/*
+		 * An entry matches if its domainname is "any" or the domainname
+		 * or the last word of the domainname, and its program is "any"
+		 * or the program.
+		 */
+		index = from_any[type];
+		if (ccs_transition_control_domain_types & (1 << type))
+			for (i = 0; i < 2; i++) {
+				index = ccs_first_transition_control
+					(index, ccs_find_transition_control
+					 (ns, names[i], program, type,
+					  CCS_TRANSITION_CONTROL_KEY_EXACT));
+				index = ccs_first_transition_control
+					(index, ccs_find_transition_control
+					 (ns, names[i], NULL, type,
+					  CCS_TRANSITION_CONTROL_KEY_EXACT));
+			}
+		if (index == EOF)
+			continue;
+		ptr = &ccs_transition_control_list[index];
+		if (type == CCS_TRANSITION_CONTROL_NO_RESET) {
+			/*
+			 * Do not check for reset_domain if no_reset_domain
+			 * matched.
+			 */
+			type = CCS_TRANSITION_CONTROL_NO_INITIALIZE;
+			goto next;
+		}
+		if (type == CCS_TRANSITION_CONTROL_NO_INITIALIZE) {
+			/*
+			 * Do not check for initialize_domain if
+			 * no_initialize_domain matched.
+			 */
+			type = CCS_TRANSITION_CONTROL_NO_KEEP;
+			goto next;
+		}
+		if (type == CCS_TRANSITION_CONTROL_RESET ||
+		    type == CCS_TRANSITION_CONTROL_INITIALIZE ||
+		    type == CCS_TRANSITION_CONTROL_KEEP)
+			return ptr;
+		else
+			return NULL;
+	}
+	return NULL;
+}
+
+/**
+ * ccs_transition_control - Find domain transition control.
+ *
+ * @ns:         Pointer to "const struct ccs_path_info".
+ * @domainname: Domainname.
+ * @program:    Program name.
+ *
+ * Returns pointer to "const struct ccs_transition_control_entry" if found one,
+ * NULL otherwise.
+ */
+static const struct ccs_transition_control_entry *ccs_transition_control
+(const struct ccs_path_info *ns, const char *domainname, const char *program)
+{
+	int from_any[CCS_MAX_TRANSITION_TYPE];
+	struct ccs_path_info domain;
+	struct ccs_path_info last_name;
+	struct ccs_path_info name;
+	domain.name = domainname;
+	last_name.name = ccs_get_last_word(domainname);
+	name.name = program;
+	ccs_fill_path_info(&domain);
+	ccs_fill_path_info(&last_name);
+	ccs_fill_path_info(&name);
+	ccs_transition_control_from_any(ns, &name, from_any);
+	return ccs_resolve_transition_control(ns, &domain, &last_name, &name,
+					      from_any);
+}
+
+/**
+ * ccs_profile_entry_compare -  strcmp() for qsort() callback.
+ *
+ * @a: Pointer to "void".
+ * @b: Pointer to "void".
+ *
+ * Returns return value of strcmp().
+ */
+static int ccs_profile_entry_compare(const void *a, const void *b)
+{
+	const struct ccs_generic_acl *a0 = (struct ccs_generic_acl *) a;
+	const struct ccs_generic_acl *b0 = (struct ccs_generic_acl *) b;
+	const char *a1 = a0->operand;
+	const char *b1 = b0->operand;
+	const int a2 = a0->directive;
+	const int b2 = b0->directive;
+	if (a2 >= 256 || b2 >= 256) {
+		if (a1[0] == 'P')
+			return -1;
+		if (b1[0] == 'P')
+			return 1;
+	}
+	if (!ccs_profile_sort_type) {
+		if (a2 == b2)
+			return strcmp(a1, b1);
 		else
 			return a2 - b2;
 	} else {
@@ -1208,6 +1842,57 @@ static int ccs_profile_entry_compare(const void *a, const void *b)
 	}
 }
 
+/**
+ * ccs_gacl_slot - Find a slot in ccs_gacl_hash.
+ *
+ * @line:      Line to find.
+ * @directive: One of values in "enum ccs_editpolicy_directives".
+ *
+ * Returns pointer to the slot which holds the index of the same entry in
+ * ccs_gacl_list if found, pointer to an unused slot (which holds EOF)
+ * otherwise.
+ *
+ * ccs_gacl_hash_size must not be 0.
+ */
+static int *ccs_gacl_slot(const char *line, const enum
+			  ccs_editpolicy_directives directive)
+{
+	const unsigned int mask = ccs_gacl_hash_size - 1;
+	const unsigned char *cp = (const unsigned char *) line;
+	unsigned int i = directive;
+	while (*cp)
+		i = (i + *cp++) * 31;
+	for (i &= mask; ccs_gacl_hash[i] != EOF; i = (i + 1) & mask) {
+		const struct ccs_generic_acl *ptr =
+			&ccs_gacl_list[ccs_gacl_hash[i]];
+		if (ptr->directive == directive && !strcmp(line, ptr->operand))
+			break;
+	}
+	return &ccs_gacl_hash[i];
+}
+
+/**
+ * ccs_rehash_gacl - Rebuild ccs_gacl_hash.
+ *
+ * @size: Number of slots. Must be a power of 2.
+ *
+ * Returns nothing.
+ */
+static void ccs_rehash_gacl(const int size)
+{
+	int i;
+	if (size != ccs_gacl_hash_size) {
+		free(ccs_gacl_hash);
+		ccs_gacl_hash = ccs_malloc(size * sizeof(int));
+		ccs_gacl_hash_size = size;
+	}
+	for (i = 0; i < size; i++)
+		ccs_gacl_hash[i] = EOF;
+	for (i = 0; i < ccs_gacl_list_count; i++)
+		*ccs_gacl_slot(ccs_gacl_list[i].operand,
+			       ccs_gacl_list[i].directive) = i;
+}
+
 /**
  * ccs_add_generic_entry - Add text lines.
  *
@@ -1215,21 +1900,28 @@ static int ccs_profile_entry_compare(const void *a, const void *b)
  * @directive: One of values in "enum ccs_editpolicy_directives".
  *
  * Returns true if this line deals current namespace, false otherwise.
+ *
+ * ccs_gacl_hash has to be valid for ccs_gacl_list, which is the case while
+ * ccs_read_generic_policy() is reading policy.
  */
 static void ccs_add_generic_entry(const char *line, const enum
 				  ccs_editpolicy_directives directive)
 {
+	int *slot;
 	int i;
-	for (i = 0; i < ccs_gacl_list_count; i++)
-		if (ccs_gacl_list[i].directive == directive &&
-		    !strcmp(line, ccs_gacl_list[i].operand))
-			return;
+	if ((ccs_gacl_list_count + 1) * 2 > ccs_gacl_hash_size)
+		ccs_rehash_gacl(ccs_gacl_hash_size ?
+				ccs_gacl_hash_size * 2 : 256);
+	slot = ccs_gacl_slot(line, directive);
+	if (*slot != EOF)
+		return;
+	ccs_gacl_list = ccs_grow(ccs_gacl_list, &ccs_gacl_list_capacity,
+				 ccs_gacl_list_count,
+				 sizeof(struct ccs_generic_acl));
 	i = ccs_gacl_list_count++;
-	ccs_gacl_list = ccs_realloc(ccs_gacl_list, ccs_gacl_list_count *
-				    sizeof(struct ccs_generic_acl));
 	ccs_gacl_list[i].directive = directive;
-	ccs_gacl_list[i].selected = 0;
 	ccs_gacl_list[i].operand = ccs_strdup(line);
+	*slot = i;
 }
 
 /**
@@ -1240,10 +1932,16 @@ static void ccs_add_generic_entry(const char *line, const enum
 static void ccs_read_generic_policy(void)
 {
 	FILE *fp = NULL;
+	struct ccs_reader reader = { };
+	unsigned int fingerprint = 0;
 	_Bool flag = false;
 	const _Bool is_kernel_ns = !strcmp(ccs_current_ns->name, "<kernel>");
-	while (ccs_gacl_list_count)
-		free((void *) ccs_gacl_list[--ccs_gacl_list_count].operand);
+	/*
+	 * ccs_gacl_list might have been reallocated elsewhere, but it still
+	 * has at least ccs_gacl_list_count elements.
+	 */
+	ccs_gacl_list_capacity = ccs_gacl_list_count;
+	ccs_generic_policy_unchanged = false;
 	if (ccs_current_screen == CCS_SCREEN_ACL_LIST) {
 		if (ccs_network_mode)
 			/* We can read after write. */
@@ -1262,19 +1960,47 @@ static void ccs_read_generic_policy(void)
 				fputc(0, fp);
 			fflush(fp);
 		}
-	} else if (ccs_current_screen == CCS_SCREEN_NS_LIST) {
-		ccs_add_generic_entry("<kernel>", CCS_DIRECTIVE_NONE);
 	}
 	if (!fp)
 		fp = ccs_editpolicy_open_read(ccs_policy_file);
+	reader.raw = ccs_current_screen == CCS_SCREEN_STAT_LIST;
+	/*
+	 * Nothing to parse if the lines shown have not changed since the last
+	 * read. They depend on the screen, the namespace and the order, and
+	 * the ACL screen depends on the domain or the process as well.
+	 */
+	if (fp && ccs_current_screen != CCS_SCREEN_ACL_LIST) {
+		if (!ccs_reader_spool(&reader, fp)) {
+			fclose(fp);
+			ccs_clear_reader(&reader);
+			ccs_generic_policy_fingerprint = 0;
+			return;
+		}
+		fingerprint = reader.fingerprint;
+		fingerprint = fingerprint * 31 + ccs_current_screen;
+		fingerprint = fingerprint * 31 + ccs_current_ns->hash;
+		fingerprint = fingerprint * 31 + ccs_profile_sort_type;
+		if (fingerprint == ccs_generic_policy_fingerprint) {
+			fclose(fp);
+			ccs_clear_reader(&reader);
+			ccs_generic_policy_unchanged = true;
+			ccs_assign_bits(ccs_gacl_selected, 0,
+					ccs_gacl_list_count, false);
+			return;
+		}
+	}
+	ccs_generic_policy_fingerprint = fingerprint;
+	while (ccs_gacl_list_count)
+		free((void *) ccs_gacl_list[--ccs_gacl_list_count].operand);
+	ccs_rehash_gacl(ccs_gacl_hash_size ? ccs_gacl_hash_size : 256);
+	if (ccs_current_screen == CCS_SCREEN_NS_LIST)
+		ccs_add_generic_entry("<kernel>", CCS_DIRECTIVE_NONE);
 	if (!fp) {
 		ccs_set_error(ccs_policy_file);
 		return;
 	}
-	ccs_freadline_raw = ccs_current_screen == CCS_SCREEN_STAT_LIST;
-	ccs_get();
 	while (true) {
-		char *line = ccs_freadline_unpack(fp);
+		char *line = ccs_reader_unpack(&reader, fp);
 		enum ccs_editpolicy_directives directive;
 		char *cp;
 		if (!line)
@@ -1351,9 +2077,10 @@ static void ccs_read_generic_policy(void)
 		}
 		ccs_add_generic_entry(line, directive);
 	}
-	ccs_put();
-	ccs_freadline_raw = false;
 	fclose(fp);
+	ccs_gacl_selected = ccs_bitmap_resize(ccs_gacl_selected,
+					      ccs_gacl_list_count);
+	ccs_clear_reader(&reader);
 	switch (ccs_current_screen) {
 	case CCS_SCREEN_ACL_LIST:
 		qsort(ccs_gacl_list, ccs_gacl_list_count,
@@ -1400,9 +2127,10 @@ static int ccs_add_transition_control_entry
 			if (!ccs_correct_path(domainname))
 				return -EINVAL;
 	ccs_transition_control_list =
-		ccs_realloc(ccs_transition_control_list,
-			    (ccs_transition_control_list_len + 1) *
-			    sizeof(struct ccs_transition_control_entry));
+		ccs_grow(ccs_transition_control_list,
+			 &ccs_transition_control_list_capacity,
+			 ccs_transition_control_list_len,
+			 sizeof(struct ccs_transition_control_entry));
 	ptr = &ccs_transition_control_list[ccs_transition_control_list_len++];
 	memset(ptr, 0, sizeof(*ptr));
 	ptr->ns = ns;
@@ -1411,9 +2139,114 @@ static int ccs_add_transition_control_entry
 	if (domainname && strcmp(domainname, "any"))
 		ptr->domainname = ccs_savename(domainname);
 	ptr->type = type;
+	ccs_index_transition_control(ccs_transition_control_list_len - 1);
 	return 0;
 }
 
+/**
+ * ccs_path_group_slot - Find a slot in ccs_path_group_hash.
+ *
+ * @ns:         Pointer to "const struct ccs_path_info".
+ * @group_name: Pointer to "const struct ccs_path_info".
+ *
+ * Returns pointer to the slot which holds index of the group in
+ * ccs_path_group_list if found, pointer to an unused slot (which holds EOF)
+ * otherwise.
+ */
+int *ccs_path_group_slot(const struct ccs_path_info *ns,
+			 const struct ccs_path_info *group_name)
+{
+	unsigned int mask;
+	unsigned int i;
+	if (!ccs_path_group_hash)
+		ccs_rehash_path_group();
+	mask = ccs_path_group_hash_size - 1;
+	i = (ns->hash * 31 + group_name->hash) & mask;
+	while (ccs_path_group_hash[i] != EOF) {
+		const struct ccs_path_group_entry *group =
+			&ccs_path_group_list[ccs_path_group_hash[i]];
+		if (!ccs_pathcmp(group->ns, ns) &&
+		    !ccs_pathcmp(group->group_name, group_name))
+			break;
+		i = (i + 1) & mask;
+	}
+	return &ccs_path_group_hash[i];
+}
+
+/**
+ * ccs_rehash_path_group - Rebuild ccs_path_group_hash.
+ *
+ * Returns nothing.
+ *
+ * Keeps the table at most half full. Must be called whenever
+ * ccs_path_group_list is shrunk.
+ */
+void ccs_rehash_path_group(void)
+{
+	int i;
+	int size = ccs_path_group_hash_size ? ccs_path_group_hash_size : 64;
+	while (size < ccs_path_group_list_len * 2)
+		size <<= 1;
+	if (size != ccs_path_group_hash_size) {
+		free(ccs_path_group_hash);
+		ccs_path_group_hash = ccs_malloc(size * sizeof(int));
+		ccs_path_group_hash_size = size;
+	}
+	for (i = 0; i < size; i++)
+		ccs_path_group_hash[i] = EOF;
+	for (i = 0; i < ccs_path_group_list_len; i++) {
+		const struct ccs_path_group_entry *group =
+			&ccs_path_group_list[i];
+		*ccs_path_group_slot(group->ns, group->group_name) = i;
+	}
+}
+
+/**
+ * ccs_path_group_member_slot - Find a slot in "struct ccs_path_group_entry"->member_hash.
+ *
+ * @group:  Pointer to "const struct ccs_path_group_entry".
+ * @member: Pointer to "const struct ccs_path_info". Must be ccs_savename()'d.
+ *
+ * Returns pointer to the slot which holds @member if found, pointer to an
+ * unused slot (which holds NULL) otherwise.
+ */
+static const struct ccs_path_info **ccs_path_group_member_slot
+(const struct ccs_path_group_entry *group, const struct ccs_path_info *member)
+{
+	const unsigned int mask = group->member_hash_size - 1;
+	unsigned int i = member->hash & mask;
+	/* Faster comparison, for they are ccs_savename'd. */
+	while (group->member_hash[i] && group->member_hash[i] != member)
+		i = (i + 1) & mask;
+	return &group->member_hash[i];
+}
+
+/**
+ * ccs_rehash_path_group_member - Rebuild "struct ccs_path_group_entry"->member_hash.
+ *
+ * @group: Pointer to "struct ccs_path_group_entry".
+ * @size:  Number of slots. Must be a power of 2.
+ *
+ * Returns nothing.
+ */
+static void ccs_rehash_path_group_member(struct ccs_path_group_entry *group,
+					 const int size)
+{
+	int i;
+	if (size != group->member_hash_size) {
+		free(group->member_hash);
+		group->member_hash =
+			ccs_malloc(size * sizeof(*group->member_hash));
+		group->member_hash_size = size;
+	} else {
+		memset(group->member_hash, 0,
+		       size * sizeof(*group->member_hash));
+	}
+	for (i = 0; i < group->member_name_len; i++)
+		*ccs_path_group_member_slot(group, group->member_name[i]) =
+			group->member_name[i];
+}
+
 /**
  * ccs_add_path_group_entry - Add "path_group" entry.
  *
@@ -1431,48 +2264,71 @@ static int ccs_add_path_group_entry(const struct ccs_path_info *ns,
 {
 	const struct ccs_path_info *saved_group_name;
 	const struct ccs_path_info *saved_member_name;
-	int i;
+	int *slot;
 	int j;
-	struct ccs_path_group_entry *group = NULL;
+	struct ccs_path_group_entry *group;
 	if (!ccs_correct_word(group_name) || !ccs_correct_word(member_name))
 		return -EINVAL;
 	saved_group_name = ccs_savename(group_name);
 	saved_member_name = ccs_savename(member_name);
-	for (i = 0; i < ccs_path_group_list_len; i++) {
-		group = &ccs_path_group_list[i];
-		if (group->ns != ns)
-			continue;
-		if (saved_group_name != group->group_name)
-			continue;
+	slot = ccs_path_group_slot(ns, saved_group_name);
+	if (*slot == EOF) {
+		if (is_delete)
+			return -ENOENT;
+		ccs_path_group_list =
+			ccs_grow(ccs_path_group_list,
+				 &ccs_path_group_list_capacity,
+				 ccs_path_group_list_len,
+				 sizeof(struct ccs_path_group_entry));
+		*slot = ccs_path_group_list_len++;
+		group = &ccs_path_group_list[*slot];
+		memset(group, 0, sizeof(*group));
+		group->ns = ns;
+		group->group_name = saved_group_name;
+		if (ccs_path_group_list_len * 2 > ccs_path_group_hash_size)
+			ccs_rehash_path_group();
+	} else {
+		group = &ccs_path_group_list[*slot];
+	}
+	/*
+	 * Check for the same member. Large groups are checked using a hash
+	 * table, others are checked by linear search.
+	 */
+	if (group->member_hash && !is_delete) {
+		if (*ccs_path_group_member_slot(group, saved_member_name))
+			return 0;
+	} else {
 		for (j = 0; j < group->member_name_len; j++) {
 			if (group->member_name[j] != saved_member_name)
 				continue;
 			if (!is_delete)
 				return 0;
-			while (j < group->member_name_len - 1)
-				group->member_name[j] =
-					group->member_name[j + 1];
+			/* Keep the order of remaining members. */
 			group->member_name_len--;
+			memmove(&group->member_name[j],
+				&group->member_name[j + 1],
+				(group->member_name_len - j) *
+				sizeof(const struct ccs_path_info *));
+			if (group->member_hash)
+				ccs_rehash_path_group_member
+					(group, group->member_hash_size);
 			return 0;
 		}
-		break;
-	}
-	if (is_delete)
-		return -ENOENT;
-	if (i == ccs_path_group_list_len) {
-		ccs_path_group_list =
-			ccs_realloc(ccs_path_group_list,
-				    (ccs_path_group_list_len + 1) *
-				    sizeof(struct ccs_path_group_entry));
-		group = &ccs_path_group_list[ccs_path_group_list_len++];
-		memset(group, 0, sizeof(*group));
-		group->ns = ns;
-		group->group_name = saved_group_name;
+		if (is_delete)
+			return -ENOENT;
 	}
 	group->member_name =
-		ccs_realloc(group->member_name, (group->member_name_len + 1) *
-			    sizeof(const struct ccs_path_info *));
+		ccs_grow(group->member_name, &group->member_name_capacity,
+			 group->member_name_len,
+			 sizeof(const struct ccs_path_info *));
 	group->member_name[group->member_name_len++] = saved_member_name;
+	if (group->member_name_len * 2 > group->member_hash_size &&
+	    group->member_name_len >= 16)
+		ccs_rehash_path_group_member(group, group->member_hash_size ?
+					     group->member_hash_size * 2 : 64);
+	else if (group->member_hash)
+		*ccs_path_group_member_slot(group, saved_member_name) =
+			saved_member_name;
 	return 0;
 }
 
@@ -1482,145 +2338,542 @@ static int ccs_add_path_group_entry(const struct ccs_path_info *ns,
  */
 static char **ccs_jump_list = NULL;
 static int ccs_jump_list_len = 0;
+static int ccs_jump_list_capacity = 0;
+
+/**
+ * ccs_add_condition_domain_transition - Add auto_domain_transition= part.
+ *
+ * @line:  Line to parse.
+ * @index: Current domain's index.
+ *
+ * Returns nothing.
+ */
+static void ccs_add_condition_domain_transition(char *line, const int index)
+{
+	static char domainname[4096];
+	int source;
+	char *cp = strrchr(line, ' ');
+	if (!cp)
+		return;
+	if (strncmp(cp, " auto_domain_transition=\"", 25))
+		return;
+	*cp = '\0';
+	cp += 25;
+	source = strlen(cp);
+	if (!source)
+		return;
+	cp[source - 1] = '\0';
+	snprintf(domainname, sizeof(domainname) - 1, "%s  %s",
+		 ccs_dp.list[index].domainname->name, cp);
+	domainname[sizeof(domainname) - 1] = '\0';
+	ccs_normalize_line(domainname);
+	ccs_jump_list = ccs_grow(ccs_jump_list, &ccs_jump_list_capacity,
+				 ccs_jump_list_len, sizeof(char *));
+	ccs_jump_list[ccs_jump_list_len++] = ccs_strdup(domainname);
+	ccs_assign_domain3(domainname, *cp == '<' ? cp : domainname, false);
+}
+
+/**
+ * ccs_add_acl_domain_transition - Add task acl.
+ *
+ * @line:  Line to parse.
+ * @index: Current domain's index.
+ *
+ * Returns nothing.
+ */
+static void ccs_add_acl_domain_transition(char *line, const int index)
+{
+	static char domainname[4096];
+	int pos;
+	/* Chop off condition part which follows domainname. */
+	for (pos = 0; line[pos]; pos++)
+		if (line[pos] == ' ' && line[pos + 1] != '/') {
+			line[pos] = '\0';
+			break;
+		}
+	if (!ccs_correct_domain(line))
+		return;
+	ccs_jump_list = ccs_grow(ccs_jump_list, &ccs_jump_list_capacity,
+				 ccs_jump_list_len, sizeof(char *));
+	ccs_jump_list[ccs_jump_list_len++] = ccs_strdup(line);
+	snprintf(domainname, sizeof(domainname) - 1, "%s  %s",
+		 ccs_dp.list[index].domainname->name, ccs_get_last_word(line));
+	domainname[sizeof(domainname) - 1] = '\0';
+	ccs_normalize_line(domainname);
+	ccs_assign_domain3(domainname, line, false);
+}
+
+/**
+ * ccs_parse_domain_line - Parse an ACL entry in domain policy.
+ *
+ * @ns:          Pointer to "const struct ccs_path_info".
+ * @line:        Line to parse.
+ * @index:       Current domain's index.
+ * @parse_flags: True if parse use_profile and use_group lines, false
+ *               otherwise.
+ *
+ * Returns nothing.
+ */
+static void ccs_parse_domain_line(const struct ccs_path_info *ns, char *line,
+				  const int index, const bool parse_flags)
+{
+	ccs_add_condition_domain_transition(line, index);
+	if (ccs_str_starts(line, "task auto_execute_handler ") ||
+	    ccs_str_starts(line, "task denied_execute_handler ") ||
+	    ccs_str_starts(line, "file execute ")) {
+		/* Chop off condition part which follows pathname. */
+		char *cp = strchr(line, ' ');
+		if (cp)
+			*cp = '\0';
+		if (*line == '@' || ccs_correct_path(line))
+			ccs_add_string_entry3(line, index);
+	} else if (ccs_str_starts(line, "task auto_domain_transition ") ||
+		   ccs_str_starts(line, "task manual_domain_transition ")) {
+		ccs_add_acl_domain_transition(line, index);
+	} else if (parse_flags) {
+		unsigned int profile;
+		if (sscanf(line, "use_profile %u", &profile) == 1)
+			ccs_dp.list[index].profile = (u8) profile;
+		else if (sscanf(line, "use_group %u", &profile) == 1)
+			ccs_dp.list[index].group = (u8) profile;
+	}
+}
+
+/**
+ * ccs_parse_exception_line - Parse an ACL entry in exception policy.
+ *
+ * @ns:   Pointer to "const struct ccs_path_info".
+ * @line: Line to parse.
+ *
+ * Returns nothing.
+ */
+static void ccs_parse_exception_line(const struct ccs_path_info *ns,
+				     char *line)
+{
+	unsigned int group;
+	for (group = 0; group < CCS_MAX_TRANSITION_TYPE; group++) {
+		if (!ccs_str_starts(line, ccs_transition_type[group]))
+			continue;
+		ccs_add_transition_control_policy(ns, line, group);
+		return;
+	}
+	if (ccs_str_starts(line, "path_group "))
+		ccs_add_path_group_policy(ns, line, false);
+	else if (ccs_str_starts(line, "address_group "))
+		ccs_add_address_group_policy(line, false);
+	else if (ccs_str_starts(line, "number_group "))
+		ccs_add_number_group_policy(line, false);
+	else if (sscanf(line, "acl_group %u", &group) == 1 && group < 256) {
+		int index;
+		line = strchr(line + 10, ' ');
+		if (!line++)
+			return;
+		for (index = 0; index < ccs_dp.list_len; index++) {
+			char *cp;
+			const struct ccs_domain *ptr = &ccs_dp.list[index];
+			if (ptr->group != group || ptr->target || ptr->is_dd)
+				continue;
+			cp = ccs_strdup(line);
+			ccs_parse_domain_line(ns, cp, index, false);
+			free(cp);
+		}
+	}
+}
+
+/**
+ * ccs_find_unreachable_domains - Mark unreachable domains.
+ *
+ * Returns nothing.
+ *
+ * A domain is unreachable if one of "initialize_domain" or "keep_domain" or
+ * "reset_domain" keyword applies to the transition into that domain or into
+ * one of its ancestors below the nearest domain jump target. The domain
+ * remembers the entry found for the topmost such transition in "d_t".
+ *
+ * The domain tree is resolved from the root toward the leaves so that every
+ * domain inherits the result of its parent and ccs_transition_control() is
+ * called at most once for each domain.
+ */
+static void ccs_find_unreachable_domains(void)
+{
+	const int max_index = ccs_dp.list_len;
+	const struct ccs_transition_control_entry **d_t;
+	_Bool *done;
+	int *parent;
+	int *stack;
+	int index;
+	if (!max_index)
+		return;
+	d_t = ccs_malloc(max_index * sizeof(*d_t));
+	done = ccs_malloc(max_index * sizeof(_Bool));
+	parent = ccs_malloc(max_index * sizeof(int));
+	stack = ccs_malloc(max_index * sizeof(int));
+	for (index = 0; index < max_index; index++) {
+		const struct ccs_domain_node *node =
+			&ccs_dp.node[ccs_dp.list[index].node];
+		parent[index] = EOF;
+		if (!ccs_dp.list[index].target && node->parent != EOF)
+			parent[index] = ccs_dp.node[node->parent].index;
+	}
+	for (index = 0; index < max_index; index++) {
+		struct ccs_domain * const domain = &ccs_dp.list[index];
+		int depth = 0;
+		int i;
+		/*
+		 * Mark domain jump source as unreachable if domain jump target
+		 * does not exist. Note that such domains are not marked with
+		 * '!'.
+		 */
+		if (domain->target) {
+			if (ccs_find_domain3(domain->target->name, NULL,
+					     false) == EOF)
+				domain->is_du = true;
+			continue;
+		}
+		/* Resolve ancestors which are not yet resolved first. */
+		for (i = index; i != EOF && !done[i]; i = parent[i])
+			stack[depth++] = i;
+		while (depth) {
+			const struct ccs_domain *ptr;
+			i = stack[--depth];
+			done[i] = true;
+			ptr = &ccs_dp.list[i];
+			/* Stop traversal if current is domain jump target. */
+			if (ptr->is_djt || parent[i] == EOF)
+				continue;
+			d_t[i] = d_t[parent[i]];
+			if (!d_t[i])
+				d_t[i] = ccs_transition_control
+					(ccs_get_ns(ptr->domainname->name),
+					 ccs_dp.list[parent[i]].domainname->name,
+					 ptr->domainname->name +
+					 ccs_dp.node[ptr->node].last_name);
+		}
+		/* Ignore if domain jump targets. */
+		if (domain->is_djt)
+			continue;
+		/* Ignore if deleted domain. */
+		if (domain->is_dd)
+			continue;
+		domain->d_t = d_t[index];
+		if (domain->d_t)
+			domain->is_du = true;
+	}
+	free(stack);
+	free(parent);
+	free(done);
+	free(d_t);
+}
+
+/**
+ * ccs_domain_digest - Calculate hash value of attributes of a domain.
+ *
+ * @index: Index in the ccs_dp.list array.
+ *
+ * Returns hash value of what the domain transition tree shows for @index.
+ */
+static unsigned int ccs_domain_digest(const int index)
+{
+	const struct ccs_domain *ptr = &ccs_dp.list[index];
+	const struct ccs_transition_control_entry *d_t = ptr->d_t;
+	unsigned int digest = ptr->number;
+	int i;
+	digest = digest * 31 + ptr->profile;
+	digest = digest * 31 + (ptr->is_djt | ptr->is_dk << 1 |
+				ptr->is_du << 2);
+	if (d_t) {
+		digest = digest * 31 + d_t->type + 1;
+		digest = digest * 31 + (d_t->program ? d_t->program->hash : 0);
+		digest = digest * 31 +
+			(d_t->domainname ? d_t->domainname->hash : 0);
+	}
+	if (ptr->target) {
+		/* Jump sources show the number of the target domain. */
+		const int target = ccs_find_target_domain(index);
+		digest = digest * 31 +
+			(target >= 0 ? ccs_dp.list[target].number : target);
+	}
+	/* Strings are not ordered. */
+	for (i = 0; ptr->strings && i < ptr->strings->string_count; i++)
+		digest += ptr->strings->string_ptr[i]->hash;
+	return digest;
+}
+
+/**
+ * ccs_diff_domain_snapshot - Find domains changed since the previous reload.
+ *
+ * Returns nothing.
+ *
+ * Sets ccs_domain_list_reshaped to true if domains were added, removed or
+ * reordered, for callers need to rebuild the whole tree in that case.
+ * Otherwise, sets ccs_changed_domain_list to indexes of domains which need to
+ * be redrawn. Then, remembers current ccs_dp.list for the next reload.
+ *
+ * Must be called before ccs_savename_reclaim(), for the snapshot refers names
+ * used by the previous reload.
+ */
+static void ccs_diff_domain_snapshot(void)
+{
+	int index;
+	ccs_changed_domain_len = 0;
+	ccs_domain_list_reshaped = ccs_domain_snapshot_len != ccs_dp.list_len;
+	if (ccs_dp.list_len > ccs_domain_snapshot_capacity) {
+		ccs_domain_snapshot_capacity = ccs_dp.list_len;
+		ccs_domain_snapshot =
+			ccs_realloc(ccs_domain_snapshot,
+				    ccs_dp.list_len *
+				    sizeof(struct ccs_domain_snapshot));
+	}
+	for (index = 0; index < ccs_dp.list_len; index++) {
+		const struct ccs_domain *ptr = &ccs_dp.list[index];
+		struct ccs_domain_snapshot *snapshot =
+			&ccs_domain_snapshot[index];
+		const unsigned int digest = ccs_domain_digest(index);
+		if (!ccs_domain_list_reshaped &&
+		    (snapshot->domainname != ptr->domainname ||
+		     snapshot->target != ptr->target ||
+		     snapshot->is_dd != ptr->is_dd))
+			ccs_domain_list_reshaped = true;
+		if (!ccs_domain_list_reshaped && snapshot->digest != digest) {
+			ccs_changed_domain_list =
+				ccs_grow(ccs_changed_domain_list,
+					 &ccs_changed_domain_capacity,
+					 ccs_changed_domain_len, sizeof(int));
+			ccs_changed_domain_list[ccs_changed_domain_len++] =
+				index;
+		}
+		snapshot->domainname = ptr->domainname;
+		snapshot->target = ptr->target;
+		snapshot->is_dd = ptr->is_dd;
+		snapshot->digest = digest;
+	}
+	ccs_domain_snapshot_len = ccs_dp.list_len;
+	if (ccs_domain_list_reshaped)
+		ccs_changed_domain_len = 0;
+}
+
+/**
+ * ccs_open_transition_policy - Open policy for reading domain transition related entries.
+ *
+ * @filename: Name of policy file.
+ *
+ * Returns pointer to "FILE" on success, NULL otherwise.
+ */
+static FILE *ccs_open_transition_policy(const char *filename)
+{
+	FILE *fp;
+	if (ccs_network_mode)
+		/* We can read after write. */
+		fp = ccs_editpolicy_open_write(filename);
+	else
+		/* Don't set error message if failed. */
+		fp = fopen(filename, "r+");
+	if (fp) {
+		fprintf(fp, "select transition_only\n");
+		if (ccs_network_mode)
+			fputc(0, fp);
+		fflush(fp);
+	} else {
+		fp = ccs_editpolicy_open_read(filename);
+	}
+	return fp;
+}
+
+/**
+ * ccs_split_domain_namespace - Build ccs_domain_ns_list and assign numbers.
+ *
+ * Returns nothing.
+ *
+ * ccs_domain_cache must be sorted by ccs_domainname_attribute_compare(), which
+ * places domains in the same namespace next to each other because every
+ * sort key starts with the namespace.
+ */
+static void ccs_split_domain_namespace(void)
+{
+	struct ccs_domain_ns_range *range = NULL;
+	int index;
+	ccs_domain_ns_list_len = 0;
+	for (index = 0; index < ccs_domain_cache_len; index++) {
+		struct ccs_domain *ptr = &ccs_domain_cache[index];
+		if (!range || !ccs_is_same_namespace(ptr->domainname->name,
+						     range->ns)) {
+			ccs_domain_ns_list =
+				ccs_grow(ccs_domain_ns_list,
+					 &ccs_domain_ns_list_capacity,
+					 ccs_domain_ns_list_len,
+					 sizeof(struct ccs_domain_ns_range));
+			range = &ccs_domain_ns_list[ccs_domain_ns_list_len++];
+			range->ns = ccs_get_ns(ptr->domainname->name);
+			range->start = index;
+			range->len = 0;
+			range->unnumbered = 0;
+		}
+		if (ptr->is_dd || ptr->target) {
+			ptr->number = -1;
+			range->unnumbered++;
+		} else {
+			ptr->number = range->len - range->unnumbered;
+		}
+		range->len++;
+	}
+}
 
 /**
- * ccs_add_condition_domain_transition - Add auto_domain_transition= part.
+ * ccs_swap_transition_state - Exchange what a reload builds with another state.
  *
- * @line:  Line to parse.
- * @index: Current domain's index.
+ * @state: Pointer to "struct ccs_transition_state".
  *
  * Returns nothing.
  */
-static void ccs_add_condition_domain_transition(char *line, const int index)
+static void ccs_swap_transition_state(struct ccs_transition_state *state)
 {
-	static char domainname[4096];
-	int source;
-	char *cp = strrchr(line, ' ');
-	if (!cp)
-		return;
-	if (strncmp(cp, " auto_domain_transition=\"", 25))
-		return;
-	*cp = '\0';
-	cp += 25;
-	source = strlen(cp);
-	if (!source)
-		return;
-	cp[source - 1] = '\0';
-	snprintf(domainname, sizeof(domainname) - 1, "%s  %s",
-		 ccs_dp.list[index].domainname->name, cp);
-	domainname[sizeof(domainname) - 1] = '\0';
-	ccs_normalize_line(domainname);
-	ccs_jump_list = ccs_realloc(ccs_jump_list,
-				    (ccs_jump_list_len + 1) * sizeof(char *));
-	ccs_jump_list[ccs_jump_list_len++] = ccs_strdup(domainname);
-	ccs_assign_domain3(domainname, *cp == '<' ? cp : domainname, false);
+	const struct ccs_transition_state tmp = *state;
+	state->dp = ccs_dp;
+	state->domain_cache = ccs_domain_cache;
+	state->domain_cache_len = ccs_domain_cache_len;
+	state->domain_cache_capacity = ccs_domain_cache_capacity;
+	state->domain_ns_list = ccs_domain_ns_list;
+	state->domain_ns_list_len = ccs_domain_ns_list_len;
+	state->domain_ns_list_capacity = ccs_domain_ns_list_capacity;
+	state->unnumbered_domain_count = ccs_unnumbered_domain_count;
+	state->transition_control_list = ccs_transition_control_list;
+	state->transition_control_list_len = ccs_transition_control_list_len;
+	state->transition_control_list_capacity =
+		ccs_transition_control_list_capacity;
+	state->transition_control_index = ccs_transition_control_index;
+	state->transition_control_index_size =
+		ccs_transition_control_index_size;
+	state->transition_control_index_len = ccs_transition_control_index_len;
+	state->transition_control_domain_types =
+		ccs_transition_control_domain_types;
+	state->jump_list = ccs_jump_list;
+	state->jump_list_len = ccs_jump_list_len;
+	state->jump_list_capacity = ccs_jump_list_capacity;
+	state->path_group_list = ccs_path_group_list;
+	state->path_group_list_len = ccs_path_group_list_len;
+	state->path_group_list_capacity = ccs_path_group_list_capacity;
+	state->path_group_hash = ccs_path_group_hash;
+	state->path_group_hash_size = ccs_path_group_hash_size;
+	ccs_dp = tmp.dp;
+	ccs_domain_cache = tmp.domain_cache;
+	ccs_domain_cache_len = tmp.domain_cache_len;
+	ccs_domain_cache_capacity = tmp.domain_cache_capacity;
+	ccs_domain_ns_list = tmp.domain_ns_list;
+	ccs_domain_ns_list_len = tmp.domain_ns_list_len;
+	ccs_domain_ns_list_capacity = tmp.domain_ns_list_capacity;
+	ccs_unnumbered_domain_count = tmp.unnumbered_domain_count;
+	ccs_transition_control_list = tmp.transition_control_list;
+	ccs_transition_control_list_len = tmp.transition_control_list_len;
+	ccs_transition_control_list_capacity =
+		tmp.transition_control_list_capacity;
+	ccs_transition_control_index = tmp.transition_control_index;
+	ccs_transition_control_index_size = tmp.transition_control_index_size;
+	ccs_transition_control_index_len = tmp.transition_control_index_len;
+	ccs_transition_control_domain_types =
+		tmp.transition_control_domain_types;
+	ccs_jump_list = tmp.jump_list;
+	ccs_jump_list_len = tmp.jump_list_len;
+	ccs_jump_list_capacity = tmp.jump_list_capacity;
+	ccs_path_group_list = tmp.path_group_list;
+	ccs_path_group_list_len = tmp.path_group_list_len;
+	ccs_path_group_list_capacity = tmp.path_group_list_capacity;
+	ccs_path_group_hash = tmp.path_group_hash;
+	ccs_path_group_hash_size = tmp.path_group_hash_size;
 }
 
 /**
- * ccs_add_acl_domain_transition - Add task acl.
+ * ccs_free_transition_state - Free a state which is not in use.
  *
- * @line:  Line to parse.
- * @index: Current domain's index.
+ * @state: Pointer to "struct ccs_transition_state".
  *
  * Returns nothing.
  */
-static void ccs_add_acl_domain_transition(char *line, const int index)
+static void ccs_free_transition_state(struct ccs_transition_state *state)
 {
-	static char domainname[4096];
-	int pos;
-	/* Chop off condition part which follows domainname. */
-	for (pos = 0; line[pos]; pos++)
-		if (line[pos] == ' ' && line[pos + 1] != '/') {
-			line[pos] = '\0';
-			break;
-		}
-	if (!ccs_correct_domain(line))
-		return;
-	ccs_jump_list = ccs_realloc(ccs_jump_list,
-				    (ccs_jump_list_len + 1) * sizeof(char *));
-	ccs_jump_list[ccs_jump_list_len++] = ccs_strdup(line);
-	snprintf(domainname, sizeof(domainname) - 1, "%s  %s",
-		 ccs_dp.list[index].domainname->name, ccs_get_last_word(line));
-	domainname[sizeof(domainname) - 1] = '\0';
-	ccs_normalize_line(domainname);
-	ccs_assign_domain3(domainname, line, false);
+	int i;
+	for (i = 0; i < state->domain_cache_len; i++)
+		ccs_free_string_entry3(&state->domain_cache[i]);
+	free(state->domain_cache);
+	free(state->domain_ns_list);
+	free(state->dp.list_selected);
+	free(state->dp.hash);
+	free(state->dp.node);
+	free(state->dp.node_hash);
+	free(state->transition_control_list);
+	free(state->transition_control_index);
+	while (state->jump_list_len)
+		free(state->jump_list[--state->jump_list_len]);
+	free(state->jump_list);
+	for (i = 0; i < state->path_group_list_len; i++) {
+		free(state->path_group_list[i].member_name);
+		free(state->path_group_list[i].member_hash);
+	}
+	free(state->path_group_list);
+	free(state->path_group_hash);
+	memset(state, 0, sizeof(*state));
 }
 
 /**
- * ccs_parse_domain_line - Parse an ACL entry in domain policy.
- *
- * @ns:          Pointer to "const struct ccs_path_info".
- * @line:        Line to parse.
- * @index:       Current domain's index.
- * @parse_flags: True if parse use_profile and use_group lines, false
- *               otherwise.
+ * ccs_release_transition_state - Free the state replaced by the last reload.
  *
  * Returns nothing.
+ *
+ * Names which only that state used are released by ccs_savename_reclaim().
+ * GPET reloads in a worker thread while its views still show the old state,
+ * and calls this from the main loop after they have been switched over.
  */
-static void ccs_parse_domain_line(const struct ccs_path_info *ns, char *line,
-				  const int index, const bool parse_flags)
+static void ccs_release_transition_state(void)
 {
-	ccs_add_condition_domain_transition(line, index);
-	if (ccs_str_starts(line, "task auto_execute_handler ") ||
-	    ccs_str_starts(line, "task denied_execute_handler ") ||
-	    ccs_str_starts(line, "file execute ")) {
-		/* Chop off condition part which follows pathname. */
-		char *cp = strchr(line, ' ');
-		if (cp)
-			*cp = '\0';
-		if (*line == '@' || ccs_correct_path(line))
-			ccs_add_string_entry3(line, index);
-	} else if (ccs_str_starts(line, "task auto_domain_transition ") ||
-		   ccs_str_starts(line, "task manual_domain_transition ")) {
-		ccs_add_acl_domain_transition(line, index);
-	} else if (parse_flags) {
-		unsigned int profile;
-		if (sscanf(line, "use_profile %u", &profile) == 1)
-			ccs_dp.list[index].profile = (u8) profile;
-		else if (sscanf(line, "use_group %u", &profile) == 1)
-			ccs_dp.list[index].group = (u8) profile;
-	}
+	if (!ccs_transition_state_retired)
+		return;
+	ccs_free_transition_state(&ccs_retired_state);
+	ccs_savename_reclaim();
+	ccs_transition_state_retired = false;
 }
 
 /**
- * ccs_parse_exception_line - Parse an ACL entry in exception policy.
- *
- * @ns:   Pointer to "const struct ccs_path_info".
- * @line: Line to parse.
+ * ccs_select_domain_namespace - Let ccs_dp show domains in current namespace.
  *
  * Returns nothing.
+ *
+ * Only points ccs_dp.list to the range of ccs_domain_cache for ccs_current_ns,
+ * so that switching namespaces does not need to parse policy again.
+ * Jump targets are looked up here rather than while drawing the tree.
  */
-static void ccs_parse_exception_line(const struct ccs_path_info *ns,
-				     char *line)
+static void ccs_select_domain_namespace(void)
 {
-	unsigned int group;
-	for (group = 0; group < CCS_MAX_TRANSITION_TYPE; group++) {
-		if (!ccs_str_starts(line, ccs_transition_type[group]))
+	int i;
+	ccs_dp.list = ccs_domain_cache;
+	ccs_dp.list_len = 0;
+	ccs_unnumbered_domain_count = 0;
+	for (i = 0; i < ccs_domain_ns_list_len; i++) {
+		const struct ccs_domain_ns_range *range =
+			&ccs_domain_ns_list[i];
+		if (range->ns != ccs_current_ns)
 			continue;
-		ccs_add_transition_control_policy(ns, line, group);
-		return;
+		ccs_dp.list = ccs_domain_cache + range->start;
+		ccs_dp.list_len = range->len;
+		ccs_unnumbered_domain_count = range->unnumbered;
+		break;
 	}
-	if (ccs_str_starts(line, "path_group "))
-		ccs_add_path_group_policy(ns, line, false);
-	else if (ccs_str_starts(line, "address_group "))
-		ccs_add_address_group_policy(line, false);
-	else if (ccs_str_starts(line, "number_group "))
-		ccs_add_number_group_policy(line, false);
-	else if (sscanf(line, "acl_group %u", &group) == 1 && group < 256) {
-		int index;
-		line = strchr(line + 10, ' ');
-		if (!line++)
-			return;
-		for (index = 0; index < ccs_dp.list_len; index++) {
-			char *cp;
-			const struct ccs_domain *ptr = &ccs_dp.list[index];
-			if (ptr->group != group || ptr->target || ptr->is_dd)
-				continue;
-			cp = ccs_strdup(line);
-			ccs_parse_domain_line(ns, cp, index, false);
-			free(cp);
+	ccs_rehash_domain3();
+	for (i = 0; i < ccs_dp.list_len; i++) {
+		struct ccs_domain *ptr = &ccs_dp.list[i];
+		const char *cp;
+		if (!ptr->target) {
+			ptr->redirect = EOF;
+			continue;
 		}
+		cp = ptr->target->name;
+		if (!ccs_is_current_namespace(cp))
+			ptr->redirect = ptr->is_du ? EOF : -2;
+		else
+			ptr->redirect = ccs_find_domain3(cp, NULL, false);
 	}
+	ccs_diff_domain_snapshot();
+	ccs_transition_policy_ns = ccs_current_ns;
+	ccs_dp.list_selected = ccs_bitmap_resize(ccs_dp.list_selected,
+						 ccs_dp.list_len);
 }
 
 /**
@@ -1634,81 +2887,111 @@ static void ccs_parse_exception_line(const struct ccs_path_info *ns,
  */
 static void ccs_read_domain_and_exception_policy(void)
 {
+	const char * const filename[2] = {
+		CCS_PROC_POLICY_DOMAIN_POLICY, CCS_PROC_POLICY_EXCEPTION_POLICY
+	};
 	FILE *fp;
 	int i;
 	int j;
 	int index;
 	int max_index;
-	static const struct ccs_path_info *ccs_kernel_ns = NULL;
+	const struct ccs_path_info *ccs_kernel_ns;
 	const struct ccs_path_info *ns;
+	struct ccs_path_info last_name;
+	struct ccs_reader reader[2] = { };
+	/* Streams are read into memory before parsing? */
+	const _Bool spool = ccs_transition_policy_ns != NULL;
 
-	while (ccs_jump_list_len)
-		free(ccs_jump_list[--ccs_jump_list_len]);
+	/*
+	 * Nothing to parse if policy has not changed since the last reload.
+	 * Domains in other namespaces are already in ccs_domain_cache.
+	 *
+	 * Streams are read into memory and hashed first, and parsed from
+	 * there only if they differ from those used for ccs_dp. The first load
+	 * has nothing to compare with, and parses while reading.
+	 */
+	if (spool) {
+		_Bool changed = false;
+		for (i = 0; i < 2; i++) {
+			_Bool spooled;
+			fp = ccs_open_transition_policy(filename[i]);
+			if (!fp) {
+				changed = true;
+				continue;
+			}
+			spooled = ccs_reader_spool(&reader[i], fp);
+			fclose(fp);
+			if (!spooled)
+				goto cancelled;
+			if (reader[i].fingerprint !=
+			    ccs_transition_policy_fingerprint[i])
+				changed = true;
+		}
+		if (!changed) {
+			if (ccs_transition_policy_ns != ccs_current_ns) {
+				ccs_select_domain_namespace();
+				goto out;
+			}
+			ccs_domain_list_reshaped = false;
+			ccs_changed_domain_len = 0;
+			ccs_assign_bits(ccs_dp.list_selected, 0,
+					ccs_dp.list_len, false);
+			goto out;
+		}
+	}
+	ccs_transition_policy_ns = NULL;
+	memset(ccs_transition_policy_fingerprint, 0,
+	       sizeof(ccs_transition_policy_fingerprint));
+	/*
+	 * Build into an empty state. The current one is retired rather than
+	 * cleared, for it is still shown until the new one is complete, and
+	 * is put back if reading is cancelled.
+	 */
+	ccs_release_transition_state();
+	ccs_swap_transition_state(&ccs_retired_state);
 	ccs_clear_domain_policy3();
-	ccs_transition_control_list_len = 0;
 	ccs_editpolicy_clear_groups();
-	if (!ccs_kernel_ns)
-		ccs_kernel_ns = ccs_savename("<kernel>");
+	/*
+	 * Names which are not used by the policy loaded below are released
+	 * by ccs_savename_reclaim() after the retired state.
+	 */
+	ccs_savename_begin();
+	if (ccs_current_ns)
+		ccs_current_ns = ccs_savename(ccs_current_ns->name);
+	ccs_kernel_ns = ccs_savename("<kernel>");
 	ns = ccs_kernel_ns;
 
 	/* Load all domain transition related entries. */
-	fp = NULL;
-	if (ccs_network_mode)
-		/* We can read after write. */
-		fp = ccs_editpolicy_open_write(CCS_PROC_POLICY_DOMAIN_POLICY);
-	else
-		/* Don't set error message if failed. */
-		fp = fopen(CCS_PROC_POLICY_DOMAIN_POLICY, "r+");
-	if (fp) {
-		fprintf(fp, "select transition_only\n");
-		if (ccs_network_mode)
-			fputc(0, fp);
-		fflush(fp);
-	} else {
-		fp = ccs_editpolicy_open_read(CCS_PROC_POLICY_DOMAIN_POLICY);
-	}
-	if (fp) {
+	fp = spool ? NULL : ccs_open_transition_policy(filename[0]);
+	if (fp || reader[0].spooled) {
 		index = EOF;
-		ccs_get();
 		while (true) {
-			char *line = ccs_freadline_unpack(fp);
+			char *line = ccs_reader_unpack(&reader[0], fp);
 			if (!line)
 				break;
 			if (*line == '<') {
 				ns = ccs_get_ns(line);
 				index = ccs_assign_domain3(line, NULL, false);
+#ifdef __GPET
+				if (gpet_domain_hook && ns == ccs_current_ns)
+					gpet_domain_hook(line);
+#endif /* __GPET */
 				continue;
 			} else if (index == EOF) {
 				continue;
 			}
 			ccs_parse_domain_line(ns, line, index, true);
 		}
-		ccs_put();
-		fclose(fp);
+		if (fp)
+			fclose(fp);
+		ccs_transition_policy_fingerprint[0] = reader[0].fingerprint;
 	}
 
 	/* Load domain transition related entries and group entries. */
-	fp = NULL;
-	if (ccs_network_mode)
-		/* We can read after write. */
-		fp = ccs_editpolicy_open_write
-			(CCS_PROC_POLICY_EXCEPTION_POLICY);
-	else
-		/* Don't set error message if failed. */
-		fp = fopen(CCS_PROC_POLICY_EXCEPTION_POLICY, "r+");
-	if (fp) {
-		fprintf(fp, "select transition_only\n");
-		if (ccs_network_mode)
-			fputc(0, fp);
-		fflush(fp);
-	} else {
-		fp = ccs_editpolicy_open_read
-			(CCS_PROC_POLICY_EXCEPTION_POLICY);
-	}
-	if (fp) {
-		ccs_get();
+	fp = spool ? NULL : ccs_open_transition_policy(filename[1]);
+	if (fp || reader[1].spooled) {
 		while (true) {
-			char *line = ccs_freadline_unpack(fp);
+			char *line = ccs_reader_unpack(&reader[1], fp);
 			if (!line)
 				break;
 			if (*line == '<') {
@@ -1722,8 +3005,17 @@ static void ccs_read_domain_and_exception_policy(void)
 				ns = ccs_kernel_ns;
 			ccs_parse_exception_line(ns, line);
 		}
-		ccs_put();
-		fclose(fp);
+		if (fp)
+			fclose(fp);
+		ccs_transition_policy_fingerprint[1] = reader[1].fingerprint;
+	}
+	ccs_clear_reader(&reader[0]);
+	ccs_clear_reader(&reader[1]);
+	if (ccs_read_cancelled) {
+		/* Drop what has been read and put the retired state back. */
+		ccs_swap_transition_state(&ccs_retired_state);
+		ccs_free_transition_state(&ccs_retired_state);
+		goto cancelled;
 	}
 
 	/*
@@ -1741,47 +3033,43 @@ static void ccs_read_domain_and_exception_policy(void)
 	 */
 	max_index = ccs_dp.list_len;
 	for (index = 0; index < max_index; index++) {
-		const char *domainname = ccs_dp.list[index].domainname->name;
-		const struct ccs_path_info **string_ptr
-			= ccs_dp.list[index].string_ptr;
-		const int max_count = ccs_dp.list[index].string_count;
+		const struct ccs_path_info *domainname =
+			ccs_dp.list[index].domainname;
+		const struct ccs_domain_strings *strings =
+			ccs_dp.list[index].strings;
+		const struct ccs_path_info **string_ptr;
+		int max_count;
 		/* Do not recursively create domain jump source. */
-		if (ccs_dp.list[index].target)
+		if (ccs_dp.list[index].target || !strings)
 			continue;
-		ns = ccs_get_ns(domainname);
+		string_ptr = strings->string_ptr;
+		max_count = strings->string_count;
+		ns = ccs_get_ns(domainname->name);
+		last_name.name = ccs_get_last_word(domainname->name);
+		ccs_fill_path_info(&last_name);
 		for (i = 0; i < max_count; i++) {
 			const char *name = string_ptr[i]->name;
 			struct ccs_path_group_entry *group;
 			if (name[0] != '@') {
-				ccs_assign_djs(ns, domainname, name);
+				ccs_assign_djs(ns, domainname, &last_name,
+					       string_ptr[i]);
 				continue;
 			}
 			group = ccs_find_path_group_ns(ns, name + 1);
 			if (!group)
 				continue;
-			for (j = 0; j < group->member_name_len; j++) {
-				name = group->member_name[j]->name;
-				ccs_assign_djs(ns, domainname, name);
-			}
+			for (j = 0; j < group->member_name_len; j++)
+				ccs_assign_djs(ns, domainname, &last_name,
+					       group->member_name[j]);
 		}
 	}
+	ccs_clear_assign_djs_memo();
 
 	/* Create missing parent domains. */
-	max_index = ccs_dp.list_len;
-	for (index = 0; index < max_index; index++) {
-		char *line;
-		ccs_get();
-		line = ccs_shprintf("%s", ccs_dp.list[index].domainname->name);
-		while (true) {
-			char *cp = strrchr(line, ' ');
-			if (!cp)
-				break;
-			*cp = '\0';
-			if (ccs_find_domain3(line, NULL, false) == EOF)
-				ccs_assign_domain3(line, NULL, true);
-		}
-		ccs_put();
-	}
+	for (i = 0; i < ccs_dp.node_len; i++)
+		if (ccs_dp.node[i].is_parent && ccs_dp.node[i].index == EOF)
+			ccs_assign_domain3(ccs_dp.node[i].domainname->name,
+					   NULL, true);
 
 	/*
 	 * All domains and jump sources have been created by now.
@@ -1810,6 +3098,7 @@ static void ccs_read_domain_and_exception_policy(void)
 	for (index = 0; index < max_index; index++) {
 		const struct ccs_domain *domain = &ccs_dp.list[index];
 		const char *domainname = domain->domainname->name;
+		struct ccs_path_info program;
 		char *cp;
 		/* Ignore domain jump sources. */
 		if (domain->target)
@@ -1821,37 +3110,26 @@ static void ccs_read_domain_and_exception_policy(void)
 		cp = strchr(domainname, ' ');
 		if (!cp++ || strchr(cp, ' '))
 			continue;
+		ns = ccs_get_ns(domainname);
+		program.name = cp;
+		ccs_fill_path_info(&program);
 		/* Check "no_initialize_domain $program from any" entry. */
-		for (i = 0; i < ccs_transition_control_list_len; i++) {
-			struct ccs_transition_control_entry *ptr
-				= &ccs_transition_control_list[i];
-			if (ptr->type != CCS_TRANSITION_CONTROL_NO_INITIALIZE)
-				continue;
-			if (!ccs_is_same_namespace(domainname, ptr->ns))
-				continue;
-			if (ptr->domainname)
-				continue;
-			if (ptr->program && strcmp(ptr->program->name, cp))
-				continue;
-			break;
-		}
-		if (i < ccs_transition_control_list_len)
+		if (ccs_find_transition_control
+		    (ns, NULL, &program, CCS_TRANSITION_CONTROL_NO_INITIALIZE,
+		     CCS_TRANSITION_CONTROL_KEY_EXACT) != EOF ||
+		    ccs_find_transition_control
+		    (ns, NULL, NULL, CCS_TRANSITION_CONTROL_NO_INITIALIZE,
+		     CCS_TRANSITION_CONTROL_KEY_EXACT) != EOF)
 			continue;
 		/*
 		 * Check "initialize_domain $program from $domainname" entry.
 		 */
-		for (i = 0; i < ccs_transition_control_list_len; i++) {
-			struct ccs_transition_control_entry *ptr
-				= &ccs_transition_control_list[i];
-			if (ptr->type != CCS_TRANSITION_CONTROL_INITIALIZE)
-				continue;
-			if (!ccs_is_same_namespace(domainname, ptr->ns))
-				continue;
-			if (ptr->program && strcmp(ptr->program->name, cp))
-				continue;
-			break;
-		}
-		if (i < ccs_transition_control_list_len)
+		if (ccs_find_transition_control
+		    (ns, NULL, &program, CCS_TRANSITION_CONTROL_INITIALIZE,
+		     CCS_TRANSITION_CONTROL_KEY_PROGRAM) != EOF ||
+		    ccs_find_transition_control
+		    (ns, NULL, NULL, CCS_TRANSITION_CONTROL_INITIALIZE,
+		     CCS_TRANSITION_CONTROL_KEY_PROGRAM) != EOF)
 			ccs_dp.list[index].is_djt = true;
 	}
 
@@ -1862,41 +3140,29 @@ static void ccs_read_domain_and_exception_policy(void)
 	for (index = 0; index < max_index; index++) {
 		const struct ccs_domain *domain = &ccs_dp.list[index];
 		const struct ccs_path_info *name = domain->domainname;
-		const char *last_name = ccs_get_last_word(name->name);
+		struct ccs_path_info last_name;
+		const struct ccs_path_info *names[3] = { name, &last_name, NULL };
 		/* Ignore domain jump sources. */
 		if (domain->target)
 			continue;
+		ns = ccs_get_ns(name->name);
+		last_name.name = ccs_get_last_word(name->name);
+		ccs_fill_path_info(&last_name);
 		/* Check "no_keep_domain any from $domainname" entry. */
-		for (i = 0; i < ccs_transition_control_list_len; i++) {
-			struct ccs_transition_control_entry *ptr
-				= &ccs_transition_control_list[i];
-			if (ptr->type != CCS_TRANSITION_CONTROL_NO_KEEP)
-				continue;
-			if (!ccs_is_same_namespace(name->name, ptr->ns))
-				continue;
-			if (ptr->program)
-				continue;
-			if (!ptr->domainname ||
-			    !ccs_pathcmp(ptr->domainname, name) ||
-			    !strcmp(ptr->domainname->name, last_name))
+		for (i = 0; i < 3; i++)
+			if (ccs_find_transition_control
+			    (ns, names[i], NULL, CCS_TRANSITION_CONTROL_NO_KEEP,
+			     CCS_TRANSITION_CONTROL_KEY_EXACT) != EOF)
 				break;
-		}
-		if (i < ccs_transition_control_list_len)
+		if (i < 3)
 			continue;
 		/* Check "keep_domain $program from $domainname" entry. */
-		for (i = 0; i < ccs_transition_control_list_len; i++) {
-			struct ccs_transition_control_entry *ptr
-				= &ccs_transition_control_list[i];
-			if (ptr->type != CCS_TRANSITION_CONTROL_KEEP)
-				continue;
-			if (!ccs_is_same_namespace(name->name, ptr->ns))
-				continue;
-			if (!ptr->domainname ||
-			    !ccs_pathcmp(ptr->domainname, name) ||
-			    !strcmp(ptr->domainname->name, last_name))
+		for (i = 0; i < 3; i++)
+			if (ccs_find_transition_control
+			    (ns, names[i], NULL, CCS_TRANSITION_CONTROL_KEEP,
+			     CCS_TRANSITION_CONTROL_KEY_DOMAIN) != EOF)
 				break;
-		}
-		if (i < ccs_transition_control_list_len)
+		if (i < 3)
 			ccs_dp.list[index].is_dk = true;
 	}
 
@@ -1905,50 +3171,7 @@ static void ccs_read_domain_and_exception_policy(void)
 	 * Unreachable domains are caused by one of "initialize_domain" keyword
 	 * or "keep_domain" keyword or "reset_domain" keyword.
 	 */
-	for (index = 0; index < max_index; index++) {
-		char *line;
-		struct ccs_domain * const domain = &ccs_dp.list[index];
-		/*
-		 * Mark domain jump source as unreachable if domain jump target
-		 * does not exist. Note that such domains are not marked with
-		 * '!'.
-		 */
-		if (domain->target) {
-			if (ccs_find_domain3(domain->target->name, NULL,
-					     false) == EOF)
-				domain->is_du = true;
-			continue;
-		}
-		/* Ignore if domain jump targets. */
-		if (domain->is_djt)
-			continue;
-		/* Ignore if deleted domain. */
-		if (domain->is_dd)
-			continue;
-		ns = ccs_get_ns(domain->domainname->name);
-		ccs_get();
-		line = ccs_shprintf("%s", domain->domainname->name);
-		while (true) {
-			const struct ccs_domain *ptr =
-				ccs_find_domain3_by_name(line);
-			const struct ccs_transition_control_entry *d_t;
-			char *cp;
-			/* Stop traversal if current is domain jump target. */
-			if (ptr && ptr->is_djt)
-				break;
-			cp = strrchr(line, ' ');
-			if (cp)
-				*cp++ = '\0';
-			else
-				break;
-			d_t = ccs_transition_control(ns, line, cp);
-			if (d_t)
-				domain->d_t = d_t;
-		}
-		ccs_put();
-		if (domain->d_t)
-			domain->is_du = true;
-	}
+	ccs_find_unreachable_domains();
 
 	/* Sort by domain name. */
 	qsort(ccs_dp.list, ccs_dp.list_len, sizeof(struct ccs_domain),
@@ -1956,40 +3179,26 @@ static void ccs_read_domain_and_exception_policy(void)
 
 	/*
 	 * Since this screen shows domain transition tree within current
-	 * namespace, purge domains that are not in current namespace.
+	 * namespace, show only domains in current namespace. Domains in other
+	 * namespaces are kept for switching namespaces.
 	 */
-	for (index = 0; index < ccs_dp.list_len; index++) {
-		int i;
-		if (ccs_is_current_namespace(ccs_dp.list[index].
-					     domainname->name))
-			continue;
-		free(ccs_dp.list[index].string_ptr);
-		ccs_dp.list_len--;
-		for (i = index; i < ccs_dp.list_len; i++)
-			ccs_dp.list[i] = ccs_dp.list[i + 1];
-		index--;
-	}
-
-	/* Assign domain numbers. */
-	{
-		int number = 0;
-		int index;
-		ccs_unnumbered_domain_count = 0;
-		for (index = 0; index < ccs_dp.list_len; index++) {
-			if (ccs_deleted_domain(index) ||
-			    ccs_jump_source(index)) {
-				ccs_dp.list[index].number = -1;
-				ccs_unnumbered_domain_count++;
-			} else {
-				ccs_dp.list[index].number = number++;
-			}
-		}
-	}
-
-	if (!ccs_dp.list_len)
-		return;
-	ccs_dp.list_selected = ccs_realloc2(ccs_dp.list_selected,
-					    ccs_dp.list_len);
+	ccs_split_domain_namespace();
+	ccs_select_domain_namespace();
+	ccs_transition_state_retired = true;
+#ifndef __GPET
+	ccs_release_transition_state();
+#endif /* __GPET */
+	return;
+cancelled:
+	/* ccs_dp may no longer match the policy. Read it again next time. */
+	ccs_transition_policy_ns = NULL;
+	memset(ccs_transition_policy_fingerprint, 0,
+	       sizeof(ccs_transition_policy_fingerprint));
+	ccs_domain_list_reshaped = false;
+	ccs_changed_domain_len = 0;
+out:
+	ccs_clear_reader(&reader[0]);
+	ccs_clear_reader(&reader[1]);
 }
 
 /**
@@ -2394,12 +3603,12 @@ static _Bool ccs_select_item(const int index)
 			if (ccs_deleted_domain(index) ||
 			    ccs_jump_source(index))
 				return false;
-			ccs_dp.list_selected[index] ^= 1;
+			ccs_change_bit(ccs_dp.list_selected, index);
 		} else {
 			ccs_task_list[index].selected ^= 1;
 		}
 	} else {
-		ccs_gacl_list[index].selected ^= 1;
+		ccs_change_bit(ccs_gacl_selected, index);
 	}
 	getyx(stdscr, y, x);
 	ccs_editpolicy_sttr_save();    /* add color */
@@ -2464,7 +3673,7 @@ static void ccs_delete_entry(const int index)
 	move(1, 0);
 	ccs_editpolicy_color_change(CCS_DISP_ERR, true);	/* add color */
 	if (ccs_current_screen == CCS_SCREEN_DOMAIN_LIST) {
-		c = ccs_count(ccs_dp.list_selected, ccs_dp.list_len);
+		c = ccs_bitmap_weight(ccs_dp.list_selected, ccs_dp.list_len);
 		if (!c && index < ccs_dp.list_len)
 			c = ccs_select_item(index);
 		if (!c)
@@ -2473,8 +3682,8 @@ static void ccs_delete_entry(const int index)
 			printw("Delete selected domain%s? ('Y'es/'N'o)",
 			       c > 1 ? "s" : "");
 	} else {
-		c = ccs_count2(ccs_gacl_list,
-			       ccs_gacl_list_count);
+		c = ccs_bitmap_weight(ccs_gacl_selected,
+				      ccs_gacl_list_count);
 		if (!c)
 			c = ccs_select_item(index);
 		if (!c)
@@ -2503,12 +3712,13 @@ static void ccs_delete_entry(const int index)
 			(CCS_PROC_POLICY_DOMAIN_POLICY);
 		if (!fp)
 			return;
-		for (i = 0; i < ccs_dp.list_len; i++) {
-			if (!ccs_dp.list_selected[i])
-				continue;
+		for (i = ccs_find_next_bit(ccs_dp.list_selected,
+					   ccs_dp.list_len, 0);
+		     i < ccs_dp.list_len;
+		     i = ccs_find_next_bit(ccs_dp.list_selected,
+					   ccs_dp.list_len, i + 1))
 			fprintf(fp, "delete %s\n",
 				ccs_dp.list[i].domainname->name);
-		}
 		ccs_close_write(fp);
 	} else {
 		int i;
@@ -2525,10 +3735,12 @@ static void ccs_delete_entry(const int index)
 				fprintf(fp, "select domain=%s\n",
 					ccs_current_domain);
 		}
-		for (i = 0; i < ccs_gacl_list_count; i++) {
+		for (i = ccs_find_next_bit(ccs_gacl_selected,
+					   ccs_gacl_list_count, 0);
+		     i < ccs_gacl_list_count;
+		     i = ccs_find_next_bit(ccs_gacl_selected,
+					   ccs_gacl_list_count, i + 1)) {
 			enum ccs_editpolicy_directives directive;
-			if (!ccs_gacl_list[i].selected)
-				continue;
 			directive = ccs_gacl_list[i].directive;
 			fprintf(fp, "delete %s %s %s\n",
 				ccs_current_screen == CCS_SCREEN_EXCEPTION_LIST
@@ -2693,7 +3905,8 @@ static void ccs_set_profile(const int current)
 	char *line;
 #ifndef __GPET
 	if (!ccs_domain_sort_type) {
-		if (!ccs_count(ccs_dp.list_selected, ccs_dp.list_len) &&
+		if (!ccs_bitmap_weight(ccs_dp.list_selected,
+				       ccs_dp.list_len) &&
 		    !ccs_select_item(current)) {
 			move(1, 0);
 			printw("Select domain using Space key first.");
@@ -2724,12 +3937,13 @@ static void ccs_set_profile(const int current)
 	if (!fp)
 		goto out;
 	if (!ccs_domain_sort_type) {
-		for (index = 0; index < ccs_dp.list_len; index++) {
-			if (!ccs_dp.list_selected[index])
-				continue;
+		for (index = ccs_find_next_bit(ccs_dp.list_selected,
+					       ccs_dp.list_len, 0);
+		     index < ccs_dp.list_len;
+		     index = ccs_find_next_bit(ccs_dp.list_selected,
+					       ccs_dp.list_len, index + 1))
 			fprintf(fp, "select domain=%s\n" "use_profile %s\n",
 				ccs_dp.list[index].domainname->name, line);
-		}
 	} else {
 		for (index = 0; index < ccs_task_list_len; index++) {
 			if (!ccs_task_list[index].selected)
@@ -2756,15 +3970,16 @@ static void ccs_set_level(const int current)
 	FILE *fp;
 	char *line;
 #ifndef __GPET
-	if (!ccs_count2(ccs_gacl_list, ccs_gacl_list_count))
+	if (!ccs_bitmap_weight(ccs_gacl_selected, ccs_gacl_list_count))
 		ccs_select_item(current);
 	ccs_editpolicy_attr_change(A_BOLD, true);  /* add color */
 	ccs_initial_readline_data = NULL;
-	for (index = 0; index < ccs_gacl_list_count; index++) {
-		char *cp;
-		if (!ccs_gacl_list[index].selected)
-			continue;
-		cp = strchr(ccs_gacl_list[index].operand, '=');
+	for (index = ccs_find_next_bit(ccs_gacl_selected,
+				       ccs_gacl_list_count, 0);
+	     index < ccs_gacl_list_count;
+	     index = ccs_find_next_bit(ccs_gacl_selected,
+				       ccs_gacl_list_count, index + 1)) {
+		char *cp = strchr(ccs_gacl_list[index].operand, '=');
 		if (!cp)
 			continue;
 		ccs_initial_readline_data = cp + 1;
@@ -2782,12 +3997,14 @@ static void ccs_set_level(const int current)
 	fp = ccs_editpolicy_open_write(CCS_PROC_POLICY_PROFILE);
 	if (!fp)
 		goto out;
-	for (index = 0; index < ccs_gacl_list_count; index++) {
+	for (index = ccs_find_next_bit(ccs_gacl_selected,
+				       ccs_gacl_list_count, 0);
+	     index < ccs_gacl_list_count;
+	     index = ccs_find_next_bit(ccs_gacl_selected,
+				       ccs_gacl_list_count, index + 1)) {
 		char *buf;
 		char *cp;
 		enum ccs_editpolicy_directives directive;
-		if (!ccs_gacl_list[index].selected)
-			continue;
 		ccs_get();
 		buf = ccs_shprintf("%s", ccs_gacl_list[index].operand);
 		cp = strchr(buf, '=');
@@ -2818,7 +4035,7 @@ static void ccs_set_quota(const int current)
 	FILE *fp;
 	char *line;
 #ifndef __GPET
-	if (!ccs_count2(ccs_gacl_list, ccs_gacl_list_count))
+	if (!ccs_bitmap_weight(ccs_gacl_selected, ccs_gacl_list_count))
 		ccs_select_item(current);
 	ccs_editpolicy_attr_change(A_BOLD, true);  /* add color */
 	line = ccs_readline(ccs_window_height - 1, 0, "Enter new value> ",
@@ -2832,11 +4049,13 @@ static void ccs_set_quota(const int current)
 	fp = ccs_editpolicy_open_write(CCS_PROC_POLICY_STAT);
 	if (!fp)
 		goto out;
-	for (index = 0; index < ccs_gacl_list_count; index++) {
+	for (index = ccs_find_next_bit(ccs_gacl_selected,
+				       ccs_gacl_list_count, 0);
+	     index < ccs_gacl_list_count;
+	     index = ccs_find_next_bit(ccs_gacl_selected,
+				       ccs_gacl_list_count, index + 1)) {
 		char *buf;
 		char *cp;
-		if (!ccs_gacl_list[index].selected)
-			continue;
 		ccs_get();
 		buf = ccs_shprintf("%s", ccs_gacl_list[index].operand);
 		cp = strchr(buf, ':');
@@ -2989,7 +4208,8 @@ static void ccs_copy_mark_state(const int current)
 			     index++)
 				ccs_task_list[index].selected = selected;
 		} else {
-			const u8 selected = ccs_dp.list_selected[current];
+			const _Bool selected =
+				ccs_test_bit(ccs_dp.list_selected, current);
 			if (ccs_deleted_domain(current) ||
 			    ccs_jump_source(current))
 				return;
@@ -2998,14 +4218,14 @@ static void ccs_copy_mark_state(const int current)
 				if (ccs_deleted_domain(index) ||
 				    ccs_jump_source(index))
 					continue;
-				ccs_dp.list_selected[index] = selected;
+				ccs_assign_bit(ccs_dp.list_selected, index,
+					       selected);
 			}
 		}
 	} else {
-		const u8 selected = ccs_gacl_list[current].selected;
-		for (index = current; index < ccs_gacl_list_count;
-		     index++)
-			ccs_gacl_list[index].selected = selected;
+		ccs_assign_bits(ccs_gacl_selected, current,
+				ccs_gacl_list_count,
+				ccs_test_bit(ccs_gacl_selected, current));
 	}
 	ccs_show_list();
 }
@@ -46,6 +46,13 @@ enum ccs_transition_type {
 	CCS_MAX_TRANSITION_TYPE
 };
 
+enum ccs_transition_control_key {
+	CCS_TRANSITION_CONTROL_KEY_EXACT,   /* Compare domainname and program. */
+	CCS_TRANSITION_CONTROL_KEY_PROGRAM, /* Compare program only. */
+	CCS_TRANSITION_CONTROL_KEY_DOMAIN,  /* Compare domainname only. */
+	CCS_MAX_TRANSITION_CONTROL_KEY
+};
+
 enum ccs_editpolicy_directives {
 	CCS_DIRECTIVE_NONE,
 	CCS_DIRECTIVE_ACL_GROUP_000,
@@ -381,8 +388,25 @@ struct ccs_transition_control_entry {
 	u8 type;
 };
 
+struct ccs_transition_control_index {
+	const struct ccs_path_info *ns;            /* NULL if unused slot */
+	const struct ccs_path_info *domainname;    /* This may be NULL */
+	const struct ccs_path_info *program;       /* This may be NULL */
+	u8 type;
+	u8 key;    /* One of values in "enum ccs_transition_control_key" */
+	int index; /* First matching entry in ccs_transition_control_list */
+};
+
+struct ccs_assign_djs_entry {
+	const struct ccs_path_info *ns;         /* NULL if unused slot */
+	const struct ccs_path_info *program;
+	/* First entry for any domain for each type, EOF if none. */
+	int index[CCS_MAX_TRANSITION_TYPE];
+};
+
 struct ccs_generic_acl {
 	enum ccs_editpolicy_directives directive;
+	/* Used by copies in GUI. ccs_gacl_selected is for ccs_gacl_list. */
 	u8 selected;
 	const char *operand;
 };
@@ -404,6 +428,10 @@ struct ccs_path_group_entry {
 	const struct ccs_path_info *group_name;
 	const struct ccs_path_info **member_name;
 	int member_name_len;
+	int member_name_capacity;
+	/* Open addressing set of member_name, NULL while member_name_len is small */
+	const struct ccs_path_info **member_hash;
+	int member_hash_size;
 };
 
 struct ccs_readline_data {
@@ -435,6 +463,8 @@ enum ccs_editpolicy_directives ccs_find_directive(const _Bool forward,
 int ccs_add_address_group_policy(char *data, const _Bool is_delete);
 int ccs_add_number_group_policy(char *data, const _Bool is_delete);
 int ccs_editpolicy_get_current(void);
+int *ccs_path_group_slot(const struct ccs_path_info *ns,
+			 const struct ccs_path_info *group_name);
 void ccs_editpolicy_attr_change(const attr_t attr, const _Bool flg);
 void ccs_editpolicy_clear_groups(void);
 void ccs_editpolicy_color_change(const attr_t attr, const _Bool flg);
@@ -445,28 +475,103 @@ void ccs_editpolicy_offline_daemon(const int listener, const int notifier);
 void ccs_editpolicy_optimize(const int current);
 void ccs_editpolicy_sttr_restore(void);
 void ccs_editpolicy_sttr_save(void);
+void ccs_rehash_path_group(void);
 struct ccs_path_group_entry *ccs_find_path_group_ns
 (const struct ccs_path_info *ns, const char *group_name);
 
+/* String entries of a domain, allocated only for domains which have them. */
+struct ccs_domain_strings {
+	const struct ccs_path_info **string_ptr;
+	int string_count;
+	int string_capacity;
+	/* Open addressing set of string_ptr, NULL while string_count is small */
+	const struct ccs_path_info **string_hash;
+	int string_hash_size;
+};
+
 struct ccs_domain {
+	/* Fields read by the marking and drawing loops. */
 	const struct ccs_path_info *domainname;
 	const struct ccs_path_info *target; /* This may be NULL */
-	const struct ccs_transition_control_entry *d_t; /* This may be NULL */
-	const struct ccs_path_info **string_ptr;
-	int string_count;
 	int number;   /* domain number (-1 if target or is_dd) */
+	int node;     /* index in ccs_domain_policy3.node */
 	u8 profile;
 	u8 group;
-	_Bool is_djt; /* domain jump target */
-	_Bool is_dk;  /* domain keeper */
-	_Bool is_du;  /* unreachable domain */
-	_Bool is_dd;  /* deleted domain */
+	_Bool is_djt:1; /* domain jump target */
+	_Bool is_dk:1;  /* domain keeper */
+	_Bool is_du:1;  /* unreachable domain */
+	_Bool is_dd:1;  /* deleted domain */
+	int redirect; /* ccs_find_target_domain() of a jump source */
+	/* Fields used only while building and drawing the tree. */
+	const struct ccs_transition_control_entry *d_t; /* This may be NULL */
+	struct ccs_domain_strings *strings; /* This may be NULL */
+};
+
+struct ccs_domain_node {
+	const struct ccs_path_info *domainname; /* Words up to this node */
+	int parent;      /* Parent node, EOF if namespace */
+	int depth;       /* Number of words minus 1 */
+	int last_name;   /* Offset of the last word in domainname */
+	int index;       /* Domain (not jump source), EOF if not assigned */
+	_Bool is_parent; /* Some node has this node as parent */
+};
+
+struct ccs_domain_snapshot {
+	const struct ccs_path_info *domainname;
+	const struct ccs_path_info *target; /* This may be NULL */
+	unsigned int digest; /* Hash of attributes shown in the tree */
+	_Bool is_dd;
+};
+
+/* Range of domains in one namespace. */
+struct ccs_domain_ns_range {
+	const struct ccs_path_info *ns;
+	int start;      /* Index of the first domain */
+	int len;        /* Number of domains */
+	int unnumbered; /* Number of domains without domain number */
 };
 
 struct ccs_domain_policy3 {
+	/* Domains in current namespace. Points to a range of all domains. */
 	struct ccs_domain *list;
 	int list_len;
-	unsigned char *list_selected;
+	unsigned long *list_selected; /* Bitmap of selected domains */
+	/* Open addressing index of "list" used by ccs_find_domain3(). */
+	int *hash;
+	int hash_size;
+	/* Trie of words in domainnames built by ccs_assign_domain3(). */
+	struct ccs_domain_node *node;
+	int node_len;
+	int node_capacity;
+	int *node_hash;
+	int node_hash_size;
+};
+
+/* Everything ccs_read_domain_and_exception_policy() builds from scratch. */
+struct ccs_transition_state {
+	struct ccs_domain_policy3 dp;
+	struct ccs_domain *domain_cache;
+	int domain_cache_len;
+	int domain_cache_capacity;
+	struct ccs_domain_ns_range *domain_ns_list;
+	int domain_ns_list_len;
+	int domain_ns_list_capacity;
+	int unnumbered_domain_count;
+	struct ccs_transition_control_entry *transition_control_list;
+	int transition_control_list_len;
+	int transition_control_list_capacity;
+	struct ccs_transition_control_index *transition_control_index;
+	int transition_control_index_size;
+	int transition_control_index_len;
+	u8 transition_control_domain_types;
+	char **jump_list;
+	int jump_list_len;
+	int jump_list_capacity;
+	struct ccs_path_group_entry *path_group_list;
+	int path_group_list_len;
+	int path_group_list_capacity;
+	int *path_group_hash;
+	int path_group_hash_size;
 };
 
 extern enum ccs_screen_type ccs_current_screen;
@@ -475,6 +580,7 @@ extern int ccs_path_group_list_len;
 extern struct ccs_domain_policy3 ccs_dp;
 extern struct ccs_editpolicy_directive ccs_directives[CCS_MAX_DIRECTIVE_INDEX];
 extern struct ccs_generic_acl *ccs_gacl_list;
+extern unsigned long *ccs_gacl_selected;
 extern struct ccs_path_group_entry *ccs_path_group_list;
 extern struct ccs_screen ccs_screen[CCS_MAXSCREEN];
 extern const struct ccs_path_info *ccs_current_ns;
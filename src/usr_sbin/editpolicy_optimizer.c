@@ -27,22 +27,28 @@ struct ccs_address_group_entry {
 	const struct ccs_path_info *group_name;
 	struct ccs_ip_address_entry *member_name;
 	int member_name_len;
+	int member_name_capacity;
 };
 
 struct ccs_number_group_entry {
 	const struct ccs_path_info *group_name;
 	struct ccs_number_entry *member_name;
 	int member_name_len;
+	int member_name_capacity;
 };
 
 /* Array of "address_group" entry. */
 static struct ccs_address_group_entry *ccs_address_group_list = NULL;
 /* Length of ccs_address_group_list array. */
 static int ccs_address_group_list_len = 0;
+/* Number of elements allocated for ccs_address_group_list array. */
+static int ccs_address_group_list_capacity = 0;
 /* Array of "number_group" entry. */
 static struct ccs_number_group_entry *ccs_number_group_list = NULL;
 /* Length of ccs_number_group_list array. */
 static int ccs_number_group_list_len = 0;
+/* Number of elements allocated for ccs_number_group_list array. */
+static int ccs_number_group_list_capacity = 0;
 
 static _Bool ccs_compare_address(const char *sarg, const char *darg);
 static _Bool ccs_compare_number(const char *sarg, const char *darg);
@@ -69,14 +75,12 @@ static struct ccs_number_group_entry *ccs_find_number_group
 struct ccs_path_group_entry *ccs_find_path_group_ns
 (const struct ccs_path_info *ns, const char *group_name)
 {
-	int i;
-	for (i = 0; i < ccs_path_group_list_len; i++) {
-		if (!ccs_pathcmp(ccs_path_group_list[i].ns, ns) &&
-		    !strcmp(group_name,
-			    ccs_path_group_list[i].group_name->name))
-			return &ccs_path_group_list[i];
-	}
-	return NULL;
+	struct ccs_path_info name;
+	int index;
+	name.name = group_name;
+	ccs_fill_path_info(&name);
+	index = *ccs_path_group_slot(ns, &name);
+	return index != EOF ? &ccs_path_group_list[index] : NULL;
 }
 
 /**
@@ -356,7 +360,7 @@ void ccs_editpolicy_optimize(const int current)
 		if (index == current)
 			/* Skip source. */
 			continue;
-		if (ccs_gacl_list[index].selected)
+		if (ccs_test_bit(ccs_gacl_selected, index))
 			/* Dest already selected. */
 			continue;
 		else if (s_index == s_index2 && s_index != d_index)
@@ -475,7 +479,7 @@ void ccs_editpolicy_optimize(const int current)
 		default:
 			continue;
 		}
-		ccs_gacl_list[index].selected = 1;
+		ccs_assign_bit(ccs_gacl_selected, index, true);
 	}
 	ccs_put();
 	free(cp);
@@ -514,7 +518,7 @@ static int ccs_add_address_group_entry(const char *group_name,
 				continue;
 			if (!is_delete)
 				return 0;
-			while (j < group->member_name_len - 1)
+			for (; j < group->member_name_len - 1; j++)
 				group->member_name[j]
 					= group->member_name[j + 1];
 			group->member_name_len--;
@@ -526,16 +530,18 @@ static int ccs_add_address_group_entry(const char *group_name,
 		return -ENOENT;
 	if (i == ccs_address_group_list_len) {
 		ccs_address_group_list =
-			ccs_realloc(ccs_address_group_list,
-				    (ccs_address_group_list_len + 1) *
-				    sizeof(struct ccs_address_group_entry));
+			ccs_grow(ccs_address_group_list,
+				 &ccs_address_group_list_capacity,
+				 ccs_address_group_list_len,
+				 sizeof(struct ccs_address_group_entry));
 		group = &ccs_address_group_list[ccs_address_group_list_len++];
 		memset(group, 0, sizeof(struct ccs_address_group_entry));
 		group->group_name = saved_group_name;
 	}
 	group->member_name =
-		ccs_realloc(group->member_name, (group->member_name_len + 1) *
-			    sizeof(const struct ccs_ip_address_entry));
+		ccs_grow(group->member_name, &group->member_name_capacity,
+			 group->member_name_len,
+			 sizeof(const struct ccs_ip_address_entry));
 	group->member_name[group->member_name_len++] = entry;
 	return 0;
 }
@@ -593,7 +599,7 @@ static int ccs_add_number_group_entry(const char *group_name,
 				continue;
 			if (!is_delete)
 				return 0;
-			while (j < group->member_name_len - 1)
+			for (; j < group->member_name_len - 1; j++)
 				group->member_name[j]
 					= group->member_name[j + 1];
 			group->member_name_len--;
@@ -605,16 +611,18 @@ static int ccs_add_number_group_entry(const char *group_name,
 		return -ENOENT;
 	if (i == ccs_number_group_list_len) {
 		ccs_number_group_list =
-			ccs_realloc(ccs_number_group_list,
-				    (ccs_number_group_list_len + 1) *
-				    sizeof(struct ccs_number_group_entry));
+			ccs_grow(ccs_number_group_list,
+				 &ccs_number_group_list_capacity,
+				 ccs_number_group_list_len,
+				 sizeof(struct ccs_number_group_entry));
 		group = &ccs_number_group_list[ccs_number_group_list_len++];
 		memset(group, 0, sizeof(struct ccs_number_group_entry));
 		group->group_name = saved_group_name;
 	}
 	group->member_name =
-		ccs_realloc(group->member_name, (group->member_name_len + 1) *
-			    sizeof(const struct ccs_number_entry));
+		ccs_grow(group->member_name, &group->member_name_capacity,
+			 group->member_name_len,
+			 sizeof(const struct ccs_number_entry));
 	group->member_name[group->member_name_len++] = entry;
 	return 0;
 }
@@ -646,9 +654,13 @@ static struct ccs_number_group_entry *ccs_find_number_group
  */
 void ccs_editpolicy_clear_groups(void)
 {
-	while (ccs_path_group_list_len)
-		free(ccs_path_group_list[--ccs_path_group_list_len].
-		     member_name);
+	while (ccs_path_group_list_len) {
+		struct ccs_path_group_entry *group =
+			&ccs_path_group_list[--ccs_path_group_list_len];
+		free(group->member_name);
+		free(group->member_hash);
+	}
+	ccs_rehash_path_group();
 	/*
 	while (ccs_address_group_list_len)
 		free(ccs_address_group_list[--ccs_address_group_list_len].